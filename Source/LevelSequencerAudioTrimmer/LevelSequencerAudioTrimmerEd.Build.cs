@@ -26,7 +26,12 @@ public class LevelSequencerAudioTrimmerEd : ModuleRules
 				, "MovieScene"
 				, "LevelSequence"
 				, "UnrealEd" // FReimportManager
+				, "EditorSubsystem" // UAudioTrimmerSubsystem
 				, "ToolMenus"
+				, "Sequencer" // USequencerToolMenuContext
+				, "AssetRegistry" // UAudioTrimmerCommandlet
+				, "DeveloperSettings" // UAudioTrimmerSettings
+				, "Json" // FAudioTrimmerReport
 			}
 		); 
 
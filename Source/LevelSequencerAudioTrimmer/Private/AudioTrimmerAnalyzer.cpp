@@ -0,0 +1,262 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerAnalyzer.h"
+//---
+#include "AudioTrimmerWav.h"
+
+namespace AudioTrimmerAnalyzer
+{
+	/** Gating step and block lengths of EBU R128 momentary loudness. */
+	constexpr double StepSeconds = 0.1;
+	constexpr int32 StepsPerBlock = 4;
+
+	/** Blocks quieter than this are ignored entirely. */
+	constexpr double AbsoluteGateLufs = -70.0;
+
+	/** Blocks quieter than the ungated loudness by more than this are ignored. */
+	constexpr double RelativeGateLu = -10.0;
+
+	/** Converts a linear amplitude into decibels, clamped to the lowest reported level. */
+	float AmplitudeToDb(double Amplitude)
+	{
+		return Amplitude > 0.0 ? FMath::Max(static_cast<float>(20.0 * FMath::LogX(10.0, Amplitude)), FAudioTrimmerAudioStats::MinDecibels) : FAudioTrimmerAudioStats::MinDecibels;
+	}
+}
+
+// Prepares the filters for the given format
+bool FAudioTrimmerAnalyzer::Init(int32 InNumChannels, uint32 InSampleRate, float SilenceThresholdDb)
+{
+	using namespace AudioTrimmerAnalyzer;
+
+	*this = FAudioTrimmerAnalyzer();
+	if (InNumChannels <= 0 || InSampleRate == 0)
+	{
+		return false;
+	}
+
+	NumChannels = InNumChannels;
+	SilenceThreshold = FMath::Pow(10.f, SilenceThresholdDb / 20.f);
+	StepFrames = FMath::Max<int64>(FMath::RoundToInt64(InSampleRate * StepSeconds), 1);
+
+	// K-weighting of ITU-R BS.1770 designed for any sample rate, matches the published 48 kHz coefficients
+	const double SampleRate = InSampleRate;
+	{
+		constexpr double Frequency = 1681.974450955533;
+		constexpr double GainDb = 3.999843853973347;
+		constexpr double Q = 0.7071752369554196;
+		const double K = FMath::Tan(PI * Frequency / SampleRate);
+		const double Vh = FMath::Pow(10.0, GainDb / 20.0);
+		const double Vb = FMath::Pow(Vh, 0.4996667741545416);
+		const double A0 = 1.0 + K / Q + K * K;
+		ShelfFilter.B0 = (Vh + Vb * K / Q + K * K) / A0;
+		ShelfFilter.B1 = 2.0 * (K * K - Vh) / A0;
+		ShelfFilter.B2 = (Vh - Vb * K / Q + K * K) / A0;
+		ShelfFilter.A1 = 2.0 * (K * K - 1.0) / A0;
+		ShelfFilter.A2 = (1.0 - K / Q + K * K) / A0;
+	}
+	{
+		constexpr double Frequency = 38.13547087602444;
+		constexpr double Q = 0.5003270373238773;
+		const double K = FMath::Tan(PI * Frequency / SampleRate);
+		const double A0 = 1.0 + K / Q + K * K;
+		HighPassFilter.B0 = 1.0;
+		HighPassFilter.B1 = -2.0;
+		HighPassFilter.B2 = 1.0;
+		HighPassFilter.A1 = 2.0 * (K * K - 1.0) / A0;
+		HighPassFilter.A2 = (1.0 - K / Q + K * K) / A0;
+	}
+
+	FilterStates.SetNum(NumChannels * 2);
+
+	// L, R, C, LFE, Ls, Rs: the LFE is excluded and surrounds are weighted up, everything else counts once
+	ChannelWeights.Init(1.0, NumChannels);
+	if (NumChannels >= 6)
+	{
+		ChannelWeights[3] = 0.0;
+		ChannelWeights[4] = 1.41;
+		ChannelWeights[5] = 1.41;
+	}
+
+	return true;
+}
+
+// Consumes interleaved frames
+void FAudioTrimmerAnalyzer::Process(TConstArrayView<float> InterleavedSamples)
+{
+	if (NumChannels <= 0)
+	{
+		return;
+	}
+
+	const int32 NumFramesInChunk = InterleavedSamples.Num() / NumChannels;
+	const int32 NumSamplesInChunk = NumFramesInChunk * NumChannels;
+	const int32 NumVectorized = NumSamplesInChunk & ~3;
+	const float* Samples = InterleavedSamples.GetData();
+
+	// Peak and energy do not depend on the channel order, so all samples go through SIMD lanes as they are
+	VectorRegister4Float PeakVector = VectorZeroFloat();
+	VectorRegister4Float SquaresVector = VectorZeroFloat();
+	for (int32 Index = 0; Index < NumVectorized; Index += 4)
+	{
+		const VectorRegister4Float Values = VectorLoad(Samples + Index);
+		PeakVector = VectorMax(PeakVector, VectorAbs(Values));
+		SquaresVector = VectorMultiplyAdd(Values, Values, SquaresVector);
+	}
+
+	alignas(16) float PeakLanes[4];
+	alignas(16) float SquaresLanes[4];
+	VectorStoreAligned(PeakVector, PeakLanes);
+	VectorStoreAligned(SquaresVector, SquaresLanes);
+	Peak = FMath::Max(Peak, FMath::Max(FMath::Max(PeakLanes[0], PeakLanes[1]), FMath::Max(PeakLanes[2], PeakLanes[3])));
+	SumOfSquares += static_cast<double>(SquaresLanes[0]) + SquaresLanes[1] + SquaresLanes[2] + SquaresLanes[3];
+
+	for (int32 Index = NumVectorized; Index < NumSamplesInChunk; ++Index)
+	{
+		Peak = FMath::Max(Peak, FMath::Abs(Samples[Index]));
+		SumOfSquares += static_cast<double>(Samples[Index]) * Samples[Index];
+	}
+
+	NumSamples += NumSamplesInChunk;
+
+	// The K-weighting filter is recursive, so loudness and silence are accumulated frame by frame
+	for (int32 FrameIndex = 0; FrameIndex < NumFramesInChunk; ++FrameIndex)
+	{
+		const float* Frame = Samples + FrameIndex * NumChannels;
+		float FramePeak = 0.f;
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			FramePeak = FMath::Max(FramePeak, FMath::Abs(Frame[Channel]));
+
+			const double Shelved = FilterSample(ShelfFilter, FilterStates[Channel * 2], Frame[Channel]);
+			const double Weighted = FilterSample(HighPassFilter, FilterStates[Channel * 2 + 1], Shelved);
+			StepSum += ChannelWeights[Channel] * Weighted * Weighted;
+		}
+
+		NumSilentFrames += FramePeak < SilenceThreshold ? 1 : 0;
+
+		if (++StepNumFrames == StepFrames)
+		{
+			StepMeanSquares.Add(StepSum / StepFrames);
+			StepSum = 0.0;
+			StepNumFrames = 0;
+		}
+	}
+
+	NumFrames += NumFramesInChunk;
+}
+
+// Returns statistics of all frames consumed so far
+FAudioTrimmerAudioStats FAudioTrimmerAnalyzer::GetStats() const
+{
+	using namespace AudioTrimmerAnalyzer;
+
+	FAudioTrimmerAudioStats Stats;
+	if (NumFrames == 0)
+	{
+		return Stats;
+	}
+
+	Stats.bIsValid = true;
+	Stats.PeakDbfs = AmplitudeToDb(Peak);
+	Stats.RmsDbfs = AmplitudeToDb(FMath::Sqrt(SumOfSquares / NumSamples));
+	Stats.SilencePercent = static_cast<float>(NumSilentFrames * 100.0 / NumFrames);
+
+	// Audio shorter than one block is measured as a single block
+	TArray<double> BlockMeanSquares;
+	if (StepMeanSquares.Num() < StepsPerBlock)
+	{
+		double Sum = StepSum;
+		for (const double StepMeanSquare : StepMeanSquares)
+		{
+			Sum += StepMeanSquare * StepFrames;
+		}
+		BlockMeanSquares.Add(Sum / NumFrames);
+	}
+	else
+	{
+		BlockMeanSquares.Reserve(StepMeanSquares.Num() - StepsPerBlock + 1);
+		for (int32 StepIndex = StepsPerBlock - 1; StepIndex < StepMeanSquares.Num(); ++StepIndex)
+		{
+			double Sum = 0.0;
+			for (int32 Offset = 0; Offset < StepsPerBlock; ++Offset)
+			{
+				Sum += StepMeanSquares[StepIndex - Offset];
+			}
+			BlockMeanSquares.Add(Sum / StepsPerBlock);
+		}
+	}
+
+	// Two-stage gating: drop near-silent blocks first, then blocks much quieter than the rest
+	auto GetGatedMeanSquare = [&BlockMeanSquares](double GateLufs, double& OutMeanSquare)
+	{
+		double Sum = 0.0;
+		int32 NumBlocks = 0;
+		for (const double BlockMeanSquare : BlockMeanSquares)
+		{
+			if (BlockMeanSquare > 0.0
+				&& GetLoudness(BlockMeanSquare) > GateLufs)
+			{
+				Sum += BlockMeanSquare;
+				++NumBlocks;
+			}
+		}
+		OutMeanSquare = NumBlocks > 0 ? Sum / NumBlocks : 0.0;
+		return NumBlocks > 0;
+	};
+
+	double AbsoluteGatedMeanSquare = 0.0;
+	double RelativeGatedMeanSquare = 0.0;
+	if (GetGatedMeanSquare(AbsoluteGateLufs, AbsoluteGatedMeanSquare)
+		&& GetGatedMeanSquare(GetLoudness(AbsoluteGatedMeanSquare) + RelativeGateLu, RelativeGatedMeanSquare))
+	{
+		Stats.IntegratedLufs = FMath::Max(static_cast<float>(GetLoudness(RelativeGatedMeanSquare)), FAudioTrimmerAudioStats::MinDecibels);
+	}
+
+	return Stats;
+}
+
+// Analyzes an uncompressed WAV file in memory
+bool FAudioTrimmerAnalyzer::AnalyzeWav(TConstArrayView<uint8> WavBytes, float SilenceThresholdDb, FAudioTrimmerAudioStats& OutStats)
+{
+	FAudioTrimmerWavHeader Header;
+	FAudioTrimmerAnalyzer Analyzer;
+	if (!FAudioTrimmerWav::ReadHeader(WavBytes, Header)
+		|| !Header.IsUncompressed()
+		|| !Analyzer.Init(Header.NumChannels, Header.SampleRate, SilenceThresholdDb))
+	{
+		return false;
+	}
+
+	// Decoded in chunks of whole frames, so floats of the whole file are never resident at once
+	const int64 FramesPerChunk = FMath::Max<int64>(FAudioTrimmerWav::StreamChunkSize / sizeof(float) / Header.NumChannels, 1);
+	const int64 ChunkBytes = FramesPerChunk * Header.BlockAlign;
+	const int64 DataEnd = FMath::Min<int64>(Header.DataOffset + Header.DataSize, WavBytes.Num());
+	TArray<float> Samples;
+	for (int64 Offset = Header.DataOffset; Offset + Header.BlockAlign <= DataEnd; Offset += ChunkBytes)
+	{
+		const int64 NumBytes = FMath::Min(ChunkBytes, (DataEnd - Offset) / Header.BlockAlign * Header.BlockAlign);
+		Samples.Reset();
+		FAudioTrimmerWav::DecodeSamples(WavBytes.Slice(static_cast<int32>(Offset), static_cast<int32>(NumBytes)), Header, Samples);
+		Analyzer.Process(Samples);
+	}
+
+	OutStats = Analyzer.GetStats();
+	return OutStats.bIsValid;
+}
+
+// Runs one sample through the filter, updating its state
+double FAudioTrimmerAnalyzer::FilterSample(const FBiquad& Filter, FBiquadState& State, double Input)
+{
+	const double Output = Filter.B0 * Input + Filter.B1 * State.X1 + Filter.B2 * State.X2 - Filter.A1 * State.Y1 - Filter.A2 * State.Y2;
+	State.X2 = State.X1;
+	State.X1 = Input;
+	State.Y2 = State.Y1;
+	State.Y1 = Output;
+	return Output;
+}
+
+// Converts a gated mean square into LUFS
+double FAudioTrimmerAnalyzer::GetLoudness(double MeanSquare)
+{
+	return MeanSquare > 0.0 ? -0.691 + 10.0 * FMath::LogX(10.0, MeanSquare) : FAudioTrimmerAudioStats::MinDecibels;
+}
@@ -0,0 +1,125 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerAsyncAction.h"
+//---
+#include "AudioTrimmerSubsystem.h"
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "LevelSequence.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AudioTrimmerAsyncAction)
+
+// Queues trimming of all audio used by the given level sequences and returns at once
+UAudioTrimmerAsyncAction* UAudioTrimmerAsyncAction::TrimLevelSequencesAsync(const TArray<ULevelSequence*>& LevelSequences)
+{
+	UAudioTrimmerAsyncAction* Action = NewObject<UAudioTrimmerAsyncAction>();
+	Action->LevelSequences.Append(LevelSequences);
+	return Action;
+}
+
+// Queues the jobs of all level sequences
+void UAudioTrimmerAsyncAction::Activate()
+{
+	UAudioTrimmerSubsystem* Subsystem = UAudioTrimmerSubsystem::Get();
+	if (!Subsystem)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Audio Trimmer Subsystem is not available, nothing is trimmed."));
+		OnFinished.Broadcast(/*bSucceeded*/false, 0, 0);
+		SetReadyToDestroy();
+		return;
+	}
+
+	// There is no game instance in the editor to keep the action alive until its jobs are finished
+	AddToRoot();
+
+	for (const ULevelSequence* LevelSequence : LevelSequences)
+	{
+		if (!LevelSequence)
+		{
+			continue;
+		}
+
+		UAudioTrimmerJob* Job = Subsystem->EnqueueLevelSequence(LevelSequence);
+		Job->OnProgress.AddDynamic(this, &ThisClass::OnJobProgress);
+		Job->OnAssetCompleted.AddDynamic(this, &ThisClass::OnJobAssetCompleted);
+		Job->OnCompleted.AddDynamic(this, &ThisClass::OnJobCompleted);
+		Jobs.Add(Job);
+	}
+
+	if (Jobs.Num() == 0)
+	{
+		OnFinished.Broadcast(/*bSucceeded*/true, 0, 0);
+		SetReadyToDestroy();
+	}
+}
+
+// Lets the action be garbage collected once all its jobs are finished
+void UAudioTrimmerAsyncAction::SetReadyToDestroy()
+{
+	if (IsRooted())
+	{
+		RemoveFromRoot();
+	}
+
+	Super::SetReadyToDestroy();
+}
+
+// Cancels all jobs of this action that are not finished yet
+void UAudioTrimmerAsyncAction::Cancel()
+{
+	for (UAudioTrimmerJob* Job : Jobs)
+	{
+		Job->Cancel();
+	}
+}
+
+// Is called after every processed batch of any job of this action
+void UAudioTrimmerAsyncAction::OnJobProgress(UAudioTrimmerJob* Job, float Progress)
+{
+	OnProgress.Broadcast(GetProgress());
+}
+
+// Is called with the outcome of every sound wave of any job of this action
+void UAudioTrimmerAsyncAction::OnJobAssetCompleted(UAudioTrimmerJob* Job, const FString& AssetPath, bool bTrimmed, const FString& Reason)
+{
+	if (bTrimmed)
+	{
+		++NumTrimmed;
+	}
+	else
+	{
+		++NumNotTrimmed;
+	}
+
+	OnAssetCompleted.Broadcast(GetProgress(), AssetPath, bTrimmed, Reason);
+}
+
+// Is called once any job of this action is finished or cancelled
+void UAudioTrimmerAsyncAction::OnJobCompleted(UAudioTrimmerJob* Job)
+{
+	++NumCompletedJobs;
+	bAnyJobCancelled |= Job->GetState() == EAudioTrimmerJobState::Cancelled;
+	OnProgress.Broadcast(GetProgress());
+
+	if (NumCompletedJobs == Jobs.Num())
+	{
+		OnFinished.Broadcast(!bAnyJobCancelled, NumTrimmed, NumNotTrimmed);
+		SetReadyToDestroy();
+	}
+}
+
+// Returns the progress of all jobs together, in the [0, 1] range
+float UAudioTrimmerAsyncAction::GetProgress() const
+{
+	if (Jobs.Num() == 0)
+	{
+		return 1.f;
+	}
+
+	float Progress = 0.f;
+	for (const UAudioTrimmerJob* Job : Jobs)
+	{
+		Progress += Job->IsDone() ? 1.f : Job->GetProgress();
+	}
+	return Progress / Jobs.Num();
+}
@@ -0,0 +1,143 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerCache.h"
+//---
+#include "AudioTrimmerAnalyzer.h"
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerUtilsLibrary.h"
+#include "AudioTrimmerWav.h"
+//---
+#include "Hash/Blake3.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace AudioTrimmerCache
+{
+	/** Increase when the trimmed output changes for the same input, so old entries are never hit. */
+	constexpr int32 Version = 2;
+
+	/** Copies the file under a unique temporary name and renames it, so other machines never see a partially written entry. */
+	bool CopyAtomically(const FString& SourcePath, const FString& DestinationPath)
+	{
+		const FString TempPath = FString::Printf(TEXT("%s.%s.tmp"), *DestinationPath, *FGuid::NewGuid().ToString());
+		if (IFileManager::Get().Copy(*TempPath, *SourcePath) != COPY_OK)
+		{
+			return false;
+		}
+
+		// Another machine might have stored the same entry in the meantime, both are identical
+		if (!IFileManager::Get().Move(*DestinationPath, *TempPath, /*Replace*/false))
+		{
+			IFileManager::Get().Delete(*TempPath, false, true, true);
+			return FPaths::FileExists(DestinationPath);
+		}
+
+		return true;
+	}
+}
+
+// Returns true if the cache is enabled in the settings
+bool FAudioTrimmerCache::IsEnabled()
+{
+	return UAudioTrimmerSettings::Get().bUseTrimCache;
+}
+
+// Returns the folder of the cache from the settings, or the one in the 'Saved' folder of the project
+FString FAudioTrimmerCache::GetCacheDirectory()
+{
+	const FString& ConfiguredDirectory = UAudioTrimmerSettings::Get().TrimCacheDirectory.Path;
+	if (!ConfiguredDirectory.IsEmpty())
+	{
+		return FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), ConfiguredDirectory);
+	}
+
+	return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AudioTrimmer"), TEXT("Cache")));
+}
+
+// Creates the key of the trimmed audio
+FString FAudioTrimmerCache::MakeKey(const FString& SourceHash, const FAudioTrimmerFrameRange& FrameRange)
+{
+	// Everything that changes the trimmed samples or their stats for the same source is part of the key
+	const UAudioTrimmerSettings& Settings = UAudioTrimmerSettings::Get();
+	const FString KeySource = FString::Printf(TEXT("%d|%s|%lld|%lld|%d|%g|%d|%g|%d|%g"),
+	                                          AudioTrimmerCache::Version, *SourceHash, FrameRange.StartFrame, FrameRange.EndFrame,
+	                                          Settings.bSnapToZeroCrossings, Settings.ZeroCrossingWindowMs,
+	                                          Settings.bApplyEdgeFades, Settings.EdgeFadeMs,
+	                                          Settings.bAnalyzeTrimmedAudio, Settings.SilenceThresholdDb);
+
+	const FTCHARToUTF8 KeySourceUtf8(*KeySource);
+	return LexToString(FBlake3::HashBuffer(KeySourceUtf8.Get(), KeySourceUtf8.Length()));
+}
+
+// Copies the cached trimmed audio of the given key into the output file
+bool FAudioTrimmerCache::Get(const FString& Key, const FString& OutputPath, FAudioTrimmerFrameRange& OutFrameRange, FAudioTrimmerAudioStats* OutStats)
+{
+	const FString EntryPath = GetEntryPath(Key);
+
+	// Range is stored first and the audio last, so an existing audio file means a complete entry
+	FString RangeString;
+	TArray<FString> Values;
+	if (!FPaths::FileExists(EntryPath + TEXT(".wav"))
+		|| !FFileHelper::LoadFileToString(RangeString, *(EntryPath + TEXT(".range")))
+		|| RangeString.TrimStartAndEnd().ParseIntoArray(Values, TEXT(" ")) < 2)
+	{
+		return false;
+	}
+
+	if (IFileManager::Get().Copy(*OutputPath, *(EntryPath + TEXT(".wav"))) != COPY_OK)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to copy trimmed audio from the cache: %s"), *EntryPath);
+		return false;
+	}
+
+	OutFrameRange = FAudioTrimmerFrameRange(FCString::Atoi64(*Values[0]), FCString::Atoi64(*Values[1]));
+
+	// Stats are stored only if the audio was analyzed
+	if (OutStats
+		&& Values.Num() >= 6)
+	{
+		OutStats->bIsValid = true;
+		OutStats->PeakDbfs = FCString::Atof(*Values[2]);
+		OutStats->RmsDbfs = FCString::Atof(*Values[3]);
+		OutStats->IntegratedLufs = FCString::Atof(*Values[4]);
+		OutStats->SilencePercent = FCString::Atof(*Values[5]);
+	}
+	return true;
+}
+
+// Stores the trimmed audio under the given key, an existing entry is kept as is
+bool FAudioTrimmerCache::Put(const FString& Key, const FString& TrimmedPath, const FAudioTrimmerFrameRange& FrameRange, const FAudioTrimmerAudioStats* Stats)
+{
+	const FString EntryPath = GetEntryPath(Key);
+	if (FPaths::FileExists(EntryPath + TEXT(".wav")))
+	{
+		return true;
+	}
+
+	const FString RangePath = EntryPath + TEXT(".range");
+	const FString TempRangePath = FString::Printf(TEXT("%s.%s.tmp"), *RangePath, *FGuid::NewGuid().ToString());
+	FString RangeString = FString::Printf(TEXT("%lld %lld"), FrameRange.StartFrame, FrameRange.EndFrame);
+	if (Stats
+		&& Stats->bIsValid)
+	{
+		RangeString += FString::Printf(TEXT(" %f %f %f %f"), Stats->PeakDbfs, Stats->RmsDbfs, Stats->IntegratedLufs, Stats->SilencePercent);
+	}
+	if (!FFileHelper::SaveStringToFile(RangeString, *TempRangePath)
+		|| !IFileManager::Get().Move(*RangePath, *TempRangePath, /*Replace*/true)
+		|| !AudioTrimmerCache::CopyAtomically(TrimmedPath, EntryPath + TEXT(".wav")))
+	{
+		IFileManager::Get().Delete(*TempRangePath, false, true, true);
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to store trimmed audio in the cache: %s"), *EntryPath);
+		return false;
+	}
+
+	return true;
+}
+
+// Returns the path of the cached file of the given key without extension
+FString FAudioTrimmerCache::GetEntryPath(const FString& Key)
+{
+	// Entries are spread over subfolders by the first characters of the key, as the derived data cache does
+	return FPaths::Combine(GetCacheDirectory(), Key.Left(2), Key);
+}
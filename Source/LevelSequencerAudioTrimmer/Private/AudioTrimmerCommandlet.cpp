@@ -0,0 +1,501 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerCommandlet.h"
+//---
+#include "AudioTrimmerJournal.h"
+#include "AudioTrimmerManifest.h"
+#include "AudioTrimmerReport.h"
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "LevelSequence.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Engine/StreamableManager.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Sound/SoundWave.h"
+//---
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AudioTrimmerCommandlet)
+
+namespace AudioTrimmerCommandlet
+{
+	/** Minimal union-find used to group level sequences that share sound waves. */
+	struct FDisjointSet
+	{
+		TArray<int32> Parents;
+
+		explicit FDisjointSet(int32 Num)
+		{
+			Parents.SetNumUninitialized(Num);
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				Parents[Index] = Index;
+			}
+		}
+
+		int32 Find(int32 Index)
+		{
+			while (Parents[Index] != Index)
+			{
+				Parents[Index] = Parents[Parents[Index]];
+				Index = Parents[Index];
+			}
+			return Index;
+		}
+
+		void Union(int32 A, int32 B)
+		{
+			A = Find(A);
+			B = Find(B);
+			if (A != B)
+			{
+				Parents[B] = A;
+			}
+		}
+	};
+
+	const FString CompletedStatus = TEXT("Completed");
+	const FString FailedStatus = TEXT("Failed");
+}
+
+// Default constructor
+UAudioTrimmerCommandlet::UAudioTrimmerCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+// Entry point of the commandlet, runs either the coordinator or the worker depending on the parameters
+int32 UAudioTrimmerCommandlet::Main(const FString& Params)
+{
+	FString ShardFile;
+	if (FParse::Value(*Params, TEXT("ShardFile="), ShardFile))
+	{
+		int32 ShardIndex = 0;
+		FParse::Value(*Params, TEXT("ShardIndex="), ShardIndex);
+		return RunWorker(ShardFile, ShardIndex);
+	}
+
+	FString ContentPath = TEXT("/Game");
+	FParse::Value(*Params, TEXT("Path="), ContentPath);
+
+	if (FParse::Param(*Params, TEXT("Manifest")))
+	{
+		return RunManifestUpdate(ContentPath);
+	}
+
+	int32 NumWorkers = GetDefaultNumWorkers();
+	FParse::Value(*Params, TEXT("Workers="), NumWorkers);
+
+	return RunCoordinator(ContentPath, FMath::Max(NumWorkers, 1));
+}
+
+// Returns how many workers fit into the available memory, each one is a whole headless editor
+int32 UAudioTrimmerCommandlet::GetDefaultNumWorkers()
+{
+	// Workers are commandlets too, so they always have a budget
+	const int64 WorkerMemoryBytes = FMath::Max<int64>(UAudioTrimmerSettings::Get().GetMemoryBudgetMB(), 1) * 1024 * 1024;
+	const int64 NumByMemory = static_cast<int64>(FPlatformMemory::GetStats().AvailablePhysical) / WorkerMemoryBytes;
+
+	// Workers mostly wait for loading and ffmpeg, so half of the cores are enough even with plenty of memory
+	const int32 MaxWorkers = FMath::Max(FPlatformMisc::NumberOfCores() / 2, 1);
+	return static_cast<int32>(FMath::Clamp<int64>(NumByMemory, 1, MaxWorkers));
+}
+
+// Splits the given level sequences into disjoint shards of similar size
+TArray<TArray<FString>> UAudioTrimmerCommandlet::PartitionIntoShards(const TArray<FAssetData>& LevelSequences, int32 NumShards)
+{
+	using namespace AudioTrimmerCommandlet;
+
+	const IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+
+	TMap<FName, int32> SequenceIndexByPackage;
+	for (int32 Index = 0; Index < LevelSequences.Num(); ++Index)
+	{
+		SequenceIndexByPackage.Add(LevelSequences[Index].PackageName, Index);
+	}
+
+	// Link sequences that share a sound wave or contain each other as sub-sequences
+	FDisjointSet Groups(LevelSequences.Num());
+	TMap<FName, int32> FirstSequenceBySoundPackage;
+	TArray<int32> NumSoundsPerSequence;
+	NumSoundsPerSequence.SetNumZeroed(LevelSequences.Num());
+
+	// Packages are classified once, as sub-sequences shared by many level sequences are reached over and over
+	TMap<FName, UClass*> ClassByPackage;
+	auto GetPackageClass = [&AssetRegistry, &ClassByPackage](FName PackageName) -> UClass*
+	{
+		if (UClass* const* FoundClass = ClassByPackage.Find(PackageName))
+		{
+			return *FoundClass;
+		}
+
+		TArray<FAssetData> PackageAssets;
+		AssetRegistry.GetAssetsByPackageName(PackageName, PackageAssets);
+		UClass* PackageClass = nullptr;
+		if (PackageAssets.ContainsByPredicate([](const FAssetData& It) { return It.IsInstanceOf(USoundWave::StaticClass()); }))
+		{
+			PackageClass = USoundWave::StaticClass();
+		}
+		else if (PackageAssets.ContainsByPredicate([](const FAssetData& It) { return It.IsInstanceOf(ULevelSequence::StaticClass()); }))
+		{
+			PackageClass = ULevelSequence::StaticClass();
+		}
+		return ClassByPackage.Add(PackageName, PackageClass);
+	};
+
+	for (int32 Index = 0; Index < LevelSequences.Num(); ++Index)
+	{
+		// Sounds of sub-sequences are trimmed by the parent too, so sub-sequences are followed transitively, even outside the given path
+		TArray<FName> Dependencies;
+		TSet<FName> VisitedPackages;
+		TArray<FName> PackagesToVisit = {LevelSequences[Index].PackageName};
+		while (PackagesToVisit.Num() > 0)
+		{
+			const FName PackageName = PackagesToVisit.Pop(EAllowShrinking::No);
+			bool bAlreadyVisited = false;
+			VisitedPackages.Add(PackageName, &bAlreadyVisited);
+			if (bAlreadyVisited)
+			{
+				continue;
+			}
+
+			TArray<FName> PackageDependencies;
+			AssetRegistry.GetDependencies(PackageName, PackageDependencies, UE::AssetRegistry::EDependencyCategory::Package);
+			for (const FName& Dependency : PackageDependencies)
+			{
+				Dependencies.Add(Dependency);
+				if (GetPackageClass(Dependency) == ULevelSequence::StaticClass())
+				{
+					PackagesToVisit.Add(Dependency);
+				}
+			}
+		}
+
+		TSet<FName> CountedSounds;
+		for (const FName& Dependency : Dependencies)
+		{
+			if (const int32* SubSequenceIndex = SequenceIndexByPackage.Find(Dependency))
+			{
+				Groups.Union(Index, *SubSequenceIndex);
+				continue;
+			}
+
+			if (GetPackageClass(Dependency) != USoundWave::StaticClass())
+			{
+				continue;
+			}
+
+			bool bAlreadyCounted = false;
+			CountedSounds.Add(Dependency, &bAlreadyCounted);
+			if (bAlreadyCounted)
+			{
+				continue;
+			}
+
+			++NumSoundsPerSequence[Index];
+			if (const int32* OtherIndex = FirstSequenceBySoundPackage.Find(Dependency))
+			{
+				Groups.Union(Index, *OtherIndex);
+			}
+			else
+			{
+				FirstSequenceBySoundPackage.Add(Dependency, Index);
+			}
+		}
+	}
+
+	// Collect groups, weighted by the number of sounds to trim
+	TMap<int32, TArray<int32>> SequencesByGroup;
+	TMap<int32, int32> WeightByGroup;
+	for (int32 Index = 0; Index < LevelSequences.Num(); ++Index)
+	{
+		const int32 Group = Groups.Find(Index);
+		SequencesByGroup.FindOrAdd(Group).Add(Index);
+		WeightByGroup.FindOrAdd(Group) += FMath::Max(NumSoundsPerSequence[Index], 1);
+	}
+
+	TArray<int32> SortedGroups;
+	SequencesByGroup.GetKeys(SortedGroups);
+	SortedGroups.Sort([&WeightByGroup](int32 A, int32 B) { return WeightByGroup[A] > WeightByGroup[B]; });
+
+	// Greedily place the heaviest groups first into the least loaded shard
+	const int32 NumResultShards = FMath::Clamp(NumShards, 1, FMath::Max(SortedGroups.Num(), 1));
+	TArray<TArray<FString>> Shards;
+	Shards.SetNum(NumResultShards);
+	TArray<int32> ShardWeights;
+	ShardWeights.SetNumZeroed(NumResultShards);
+
+	for (const int32 Group : SortedGroups)
+	{
+		int32 LightestShard = 0;
+		for (int32 ShardIndex = 1; ShardIndex < NumResultShards; ++ShardIndex)
+		{
+			if (ShardWeights[ShardIndex] < ShardWeights[LightestShard])
+			{
+				LightestShard = ShardIndex;
+			}
+		}
+
+		for (const int32 SequenceIndex : SequencesByGroup[Group])
+		{
+			Shards[LightestShard].Add(LevelSequences[SequenceIndex].GetObjectPathString());
+		}
+		ShardWeights[LightestShard] += WeightByGroup[Group];
+	}
+
+	Shards.RemoveAll([](const TArray<FString>& Shard) { return Shard.IsEmpty(); });
+	return Shards;
+}
+
+// Returns the folder where shard files and summaries are stored
+FString UAudioTrimmerCommandlet::GetShardsDirectory()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AudioTrimmer"), TEXT("Shards")));
+}
+
+// Finds all level sequences, launches one worker process per shard and merges their summaries
+int32 UAudioTrimmerCommandlet::RunCoordinator(const FString& ContentPath, int32 NumWorkers)
+{
+	IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+	AssetRegistry.SearchAllAssets(/*bSynchronousSearch*/true);
+
+	FARFilter Filter;
+	Filter.ClassPaths.Add(ULevelSequence::StaticClass()->GetClassPathName());
+	Filter.PackagePaths.Add(*ContentPath);
+	Filter.bRecursivePaths = true;
+
+	TArray<FAssetData> LevelSequences;
+	AssetRegistry.GetAssets(Filter, LevelSequences);
+	if (LevelSequences.IsEmpty())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("No level sequences found under: %s"), *ContentPath);
+		return 0;
+	}
+
+	// Reports written by workers after this moment belong to this run
+	const FDateTime RunStartTime = FDateTime::UtcNow();
+
+	// Workers run in parallel, so the project report measures the wall time of the whole run
+	FAudioTrimmerReport ProjectReport(TEXT("Project"));
+
+	const TArray<TArray<FString>> Shards = PartitionIntoShards(LevelSequences, NumWorkers);
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Partitioned %d level sequences into %d shards."), LevelSequences.Num(), Shards.Num());
+
+	const FString ShardsDirectory = GetShardsDirectory();
+	IFileManager::Get().MakeDirectory(*ShardsDirectory, /*Tree*/true);
+
+	// Launch one headless worker per shard
+	const FString WorkerPath = GetWorkerExecutablePath();
+	const FString ProjectPath = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	TArray<FProcHandle> Workers;
+	for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+	{
+		const FString ShardFile = FPaths::Combine(ShardsDirectory, FString::Printf(TEXT("Shard_%d.txt"), ShardIndex));
+		FFileHelper::SaveStringArrayToFile(Shards[ShardIndex], *ShardFile);
+		IFileManager::Get().Delete(*GetShardSummaryPath(ShardIndex), false, true, true);
+
+		const FString WorkerArgs = FString::Printf(TEXT("\"%s\" -run=AudioTrimmer -ShardFile=\"%s\" -ShardIndex=%d -unattended -nopause -nosplash -nullrhi"), *ProjectPath, *ShardFile, ShardIndex);
+		FProcHandle Worker = FPlatformProcess::CreateProc(*WorkerPath, *WorkerArgs, /*bLaunchDetached*/true, /*bLaunchHidden*/true, /*bLaunchReallyHidden*/true, nullptr, 0, nullptr, nullptr);
+		if (!Worker.IsValid())
+		{
+			UE_LOG(LogAudioTrimmer, Error, TEXT("Failed to launch worker for shard %d: %s %s"), ShardIndex, *WorkerPath, *WorkerArgs);
+		}
+		Workers.Add(Worker);
+	}
+
+	int32 NumFailedWorkers = 0;
+	for (int32 ShardIndex = 0; ShardIndex < Workers.Num(); ++ShardIndex)
+	{
+		FProcHandle& Worker = Workers[ShardIndex];
+		int32 ReturnCode = INDEX_NONE;
+		if (Worker.IsValid())
+		{
+			FPlatformProcess::WaitForProc(Worker);
+			FPlatformProcess::GetProcReturnCode(Worker, &ReturnCode);
+			FPlatformProcess::CloseProc(Worker);
+		}
+
+		if (ReturnCode != 0)
+		{
+			UE_LOG(LogAudioTrimmer, Error, TEXT("Worker of shard %d finished with code %d."), ShardIndex, ReturnCode);
+			++NumFailedWorkers;
+		}
+	}
+
+	// Merge summaries of all workers, sequences missing in them were interrupted and will be resumed from their journals
+	TArray<FString> MergedSummary;
+	TSet<FString> CompletedSequences;
+	TSet<FString> FailedSequences;
+	for (int32 ShardIndex = 0; ShardIndex < Shards.Num(); ++ShardIndex)
+	{
+		TArray<FString> ShardSummary;
+		FFileHelper::LoadFileToStringArray(ShardSummary, *GetShardSummaryPath(ShardIndex));
+		for (const FString& Line : ShardSummary)
+		{
+			FString Status, SequencePath;
+			if (!Line.Split(TEXT("\t"), &Status, &SequencePath))
+			{
+				continue;
+			}
+
+			if (Status == AudioTrimmerCommandlet::CompletedStatus)
+			{
+				CompletedSequences.Add(SequencePath);
+			}
+			else if (Status == AudioTrimmerCommandlet::FailedStatus)
+			{
+				FailedSequences.Add(SequencePath);
+			}
+
+			MergedSummary.Add(FString::Printf(TEXT("%d\t%s"), ShardIndex, *Line));
+		}
+	}
+
+	for (const TArray<FString>& Shard : Shards)
+	{
+		for (const FString& SequencePath : Shard)
+		{
+			if (FailedSequences.Contains(SequencePath))
+			{
+				UE_LOG(LogAudioTrimmer, Error, TEXT("Level sequence failed, see its report: %s"), *SequencePath);
+			}
+			else if (!CompletedSequences.Contains(SequencePath))
+			{
+				UE_LOG(LogAudioTrimmer, Warning, TEXT("Level sequence was not completed, rerun to resume it: %s"), *SequencePath);
+			}
+		}
+	}
+
+	FFileHelper::SaveStringArrayToFile(MergedSummary, *FPaths::Combine(ShardsDirectory, TEXT("Summary.txt")));
+
+	// Merge reports of all level sequences into the project totals
+	TArray<FString> ReportFiles;
+	IFileManager::Get().FindFiles(ReportFiles, *FPaths::Combine(FAudioTrimmerReport::GetReportsDirectory(), TEXT("*.json")), true, false);
+	for (const FString& ReportFile : ReportFiles)
+	{
+		const FString ReportPath = FPaths::Combine(FAudioTrimmerReport::GetReportsDirectory(), ReportFile);
+		FAudioTrimmerReport SequenceReport(ReportFile);
+		if (IFileManager::Get().GetTimeStamp(*ReportPath) >= RunStartTime
+			&& SequenceReport.LoadJson(ReportPath))
+		{
+			ProjectReport.Append(SequenceReport);
+		}
+	}
+	ProjectReport.Finish();
+	ProjectReport.Save();
+
+	TArray<FString> LeftJournals;
+	IFileManager::Get().FindFiles(LeftJournals, *FPaths::Combine(FAudioTrimmerJournal::GetJournalDirectory(), TEXT("*.journal")), true, false);
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Sharded run complete: %d of %d level sequences completed, %d failed, %d interrupted journals left, %d workers failed."),
+	       CompletedSequences.Num(), LevelSequences.Num(), FailedSequences.Num(), LeftJournals.Num(), NumFailedWorkers);
+
+	return NumFailedWorkers == 0 && CompletedSequences.Num() == LevelSequences.Num() ? 0 : 1;
+}
+
+// Refreshes the usage manifest of level sequences under the given path without trimming anything
+int32 UAudioTrimmerCommandlet::RunManifestUpdate(const FString& ContentPath)
+{
+	FAudioTrimmerManifest Manifest;
+	Manifest.Load();
+	Manifest.Refresh(ContentPath);
+	return Manifest.Save() ? 0 : 1;
+}
+
+// Trims every level sequence listed in the shard file and writes the shard summary
+int32 UAudioTrimmerCommandlet::RunWorker(const FString& ShardFile, int32 ShardIndex)
+{
+	TArray<FString> SequencePaths;
+	if (!FFileHelper::LoadFileToStringArray(SequencePaths, *ShardFile))
+	{
+		UE_LOG(LogAudioTrimmer, Error, TEXT("Failed to read shard file: %s"), *ShardFile);
+		return 1;
+	}
+
+	const FString SummaryPath = GetShardSummaryPath(ShardIndex);
+	int32 NumFailed = 0;
+
+	// Next level sequences are loaded in the background together with their sound waves while the current one is trimmed
+	FStreamableManager StreamableManager;
+	TArray<TSharedPtr<FStreamableHandle>> PrefetchHandles;
+	PrefetchHandles.SetNum(SequencePaths.Num());
+	const int32 PrefetchCount = UAudioTrimmerSettings::Get().PrefetchCount;
+
+	for (int32 SequenceIndex = 0; SequenceIndex < SequencePaths.Num(); ++SequenceIndex)
+	{
+		// Over the memory budget only the current sequence is loaded
+		const int32 LastPrefetchIndex = UAudioTrimmerUtilsLibrary::IsOverMemoryBudget() ? SequenceIndex : FMath::Min(SequenceIndex + PrefetchCount, SequencePaths.Num() - 1);
+		for (int32 PrefetchIndex = SequenceIndex; PrefetchIndex <= LastPrefetchIndex; ++PrefetchIndex)
+		{
+			if (!PrefetchHandles[PrefetchIndex])
+			{
+				PrefetchHandles[PrefetchIndex] = StreamableManager.RequestAsyncLoad(FSoftObjectPath(SequencePaths[PrefetchIndex]));
+			}
+		}
+
+		const FString& SequencePath = SequencePaths[SequenceIndex];
+		if (PrefetchHandles[SequenceIndex])
+		{
+			PrefetchHandles[SequenceIndex]->WaitUntilComplete();
+		}
+
+		bool bSucceeded = false;
+		const ULevelSequence* LevelSequence = LoadObject<ULevelSequence>(nullptr, *SequencePath);
+		if (!LevelSequence)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to load level sequence: %s"), *SequencePath);
+		}
+		else if (!UAudioTrimmerUtilsLibrary::RunLevelSequenceAudioTrimmer(LevelSequence))
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Some sound waves of level sequence failed to be trimmed, see its report: %s"), *SequencePath);
+		}
+		else
+		{
+			bSucceeded = true;
+		}
+
+		NumFailed += bSucceeded ? 0 : 1;
+
+		// Written after each sequence, so the coordinator knows what is done even if this worker crashes
+		const FString Status = bSucceeded ? AudioTrimmerCommandlet::CompletedStatus : AudioTrimmerCommandlet::FailedStatus;
+		const FString Line = FString::Printf(TEXT("%s\t%s%s"), *Status, *SequencePath, LINE_TERMINATOR);
+		FFileHelper::SaveStringToFile(Line, *SummaryPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+
+		// Trimmed sequence is not needed anymore, so it can be garbage collected
+		if (PrefetchHandles[SequenceIndex])
+		{
+			PrefetchHandles[SequenceIndex]->ReleaseHandle();
+			PrefetchHandles[SequenceIndex].Reset();
+		}
+
+		// Window of trimmed sequences is unloaded once the budget is exceeded, so memory stays flat regardless of the shard size
+		UAudioTrimmerUtilsLibrary::CollectGarbageIfOverBudget();
+	}
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Shard %d complete: %d level sequences, %d failed."), ShardIndex, SequencePaths.Num(), NumFailed);
+	return NumFailed == 0 ? 0 : 1;
+}
+
+// Returns the executable used to launch headless workers
+FString UAudioTrimmerCommandlet::GetWorkerExecutablePath()
+{
+	// Prefer the console editor, fall back to the executable of the current process
+	const FString CmdPath = FPlatformProcess::GenerateApplicationPath(TEXT("UnrealEditor-Cmd"), FApp::GetBuildConfiguration());
+	if (FPaths::FileExists(CmdPath))
+	{
+		return CmdPath;
+	}
+
+	return FPlatformProcess::ExecutablePath();
+}
+
+// Returns the path to the summary written by the worker of given shard
+FString UAudioTrimmerCommandlet::GetShardSummaryPath(int32 ShardIndex)
+{
+	return FPaths::Combine(GetShardsDirectory(), FString::Printf(TEXT("Shard_%d_Summary.txt"), ShardIndex));
+}
@@ -0,0 +1,249 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerCook.h"
+//---
+#include "AudioTrimmerManifest.h"
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerUtilsLibrary.h"
+#include "AudioTrimmerWav.h"
+//---
+#include "LevelSequence.h"
+#include "HAL/FileManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "Sections/MovieSceneAudioSection.h"
+#include "Sound/SoundWave.h"
+#include "UObject/UObjectIterator.h"
+
+// Returns true if the current process is a full cook and trimming at cook time is enabled in the settings
+bool FAudioTrimmerCookTrimmer::ShouldTrimAtCookTime()
+{
+	if (!IsRunningCookCommandlet()
+		|| !UAudioTrimmerSettings::Get().bTrimAtCookTime)
+	{
+		return false;
+	}
+
+	// A sequence recooked against a sound wave cooked by a previous cook would play at the wrong offset
+	if (IsIterativeCook())
+	{
+		UE_LOG(LogAudioTrimmer, Error, TEXT("Cook-time trimming needs a full cook, since trimmed ranges are not tracked by iterative cooks. Cook without -iterate or disable 'Trim At Cook Time'."));
+		return false;
+	}
+
+	return true;
+}
+
+// Returns true if the current cook keeps packages cooked by a previous one
+bool FAudioTrimmerCookTrimmer::IsIterativeCook()
+{
+	const TCHAR* CommandLine = FCommandLine::Get();
+	return FParse::Param(CommandLine, TEXT("iterate"))
+		|| FParse::Param(CommandLine, TEXT("iteratesharedcookedbuild"))
+		|| FParse::Param(CommandLine, TEXT("cookincremental"));
+}
+
+// Collects usage of all sound waves and starts trimming loaded assets
+void FAudioTrimmerCookTrimmer::Start()
+{
+	BuildUsage();
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Cook-time trimming is enabled for %d sound waves."), UsageBySound.Num());
+
+	OnAssetLoadedHandle = FCoreUObjectDelegates::OnAssetLoaded.AddRaw(this, &FAudioTrimmerCookTrimmer::OnAssetLoaded);
+
+	// Sound waves first, so sequences already loaded by the scan are rebased onto trimmed audio
+	for (TObjectIterator<USoundWave> It; It; ++It)
+	{
+		OnAssetLoaded(*It);
+	}
+
+	for (TObjectIterator<ULevelSequence> It; It; ++It)
+	{
+		OnAssetLoaded(*It);
+	}
+}
+
+// Stops trimming newly loaded assets
+void FAudioTrimmerCookTrimmer::Stop()
+{
+	FCoreUObjectDelegates::OnAssetLoaded.Remove(OnAssetLoadedHandle);
+	OnAssetLoadedHandle.Reset();
+
+	UsageBySound.Empty();
+	ProcessedObjects.Empty();
+
+	IFileManager::Get().DeleteDirectory(*GetTempDirectory(), /*RequireExists*/false, /*Tree*/true);
+}
+
+// Reads the used range of each sound wave from the usage manifest, refreshing it first
+void FAudioTrimmerCookTrimmer::BuildUsage()
+{
+	// Only level sequences changed since the last refresh are loaded, plugins can cook their own level sequences too
+	FAudioTrimmerManifest Manifest;
+	Manifest.Load();
+
+	TArray<FString> RootPaths;
+	FPackageName::QueryRootContentPaths(RootPaths);
+	for (FString& RootPath : RootPaths)
+	{
+		RootPath.RemoveFromEnd(TEXT("/"));
+		Manifest.Refresh(RootPath);
+	}
+
+	Manifest.Save();
+
+	// A sound wave shared by several sequences is trimmed once to the union of all its used ranges
+	const TMap<FString, TArray<const FAudioTrimmerSectionUsage*>> UsagesBySound = Manifest.GetUsagesBySound();
+	UsageBySound.Empty(UsagesBySound.Num());
+	for (const TTuple<FString, TArray<const FAudioTrimmerSectionUsage*>>& It : UsagesBySound)
+	{
+		FAudioTrimmerAssetPlan UsedRange;
+		for (const FAudioTrimmerSectionUsage* SectionUsage : It.Value)
+		{
+			UsedRange.AddUsedRange(SectionUsage->GetStartTimeMs(), SectionUsage->GetEndTimeMs());
+		}
+
+		FSoundUsage& Usage = UsageBySound.Add(It.Key);
+		Usage.StartTimeMs = UsedRange.StartTimeMs;
+		Usage.EndTimeMs = UsedRange.EndTimeMs;
+	}
+}
+
+// Is called for every loaded asset to trim sound waves and rebase level sequences
+void FAudioTrimmerCookTrimmer::OnAssetLoaded(UObject* Object)
+{
+	if (!Object
+		|| ProcessedObjects.Contains(Object))
+	{
+		return;
+	}
+
+	if (USoundWave* SoundWave = Cast<USoundWave>(Object))
+	{
+		TrimSoundWave(SoundWave);
+	}
+	else if (ULevelSequence* LevelSequence = Cast<ULevelSequence>(Object))
+	{
+		ProcessedObjects.Add(Object);
+		RebaseLevelSequence(LevelSequence);
+	}
+}
+
+// Trims the source payload of the sound wave in memory
+bool FAudioTrimmerCookTrimmer::TrimSoundWave(USoundWave* SoundWave)
+{
+	FSoundUsage* Usage = SoundWave ? UsageBySound.Find(SoundWave->GetPathName()) : nullptr;
+	if (!Usage)
+	{
+		return false;
+	}
+
+	if (ProcessedObjects.Contains(SoundWave))
+	{
+		return Usage->TrimStartTimeSec >= 0.0;
+	}
+	ProcessedObjects.Add(SoundWave);
+
+	// The policy needs the loaded sound wave, so it is applied only now
+	TArray<FAudioTrimmerAssetPlan> AssetPlans;
+	FAudioTrimmerAssetPlan& AssetPlan = AssetPlans.AddDefaulted_GetRef();
+	AssetPlan.SoundWave = SoundWave;
+	AssetPlan.AddUsedRange(Usage->StartTimeMs, Usage->EndTimeMs);
+	UAudioTrimmerUtilsLibrary::ApplyTrimmingPolicy(AssetPlans);
+	if (!AssetPlan.SkipReason.IsEmpty())
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Skipping %s: %s"), *SoundWave->GetName(), *AssetPlan.SkipReason);
+		return false;
+	}
+
+	// Only uncompressed sources are trimmed, anything else would need ffmpeg during the cook
+	const FSharedBuffer SourcePayload = SoundWave->RawData.GetPayload().Get();
+	if (SourcePayload.IsNull())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to get the source audio of %s. Skipping..."), *SoundWave->GetName());
+		return false;
+	}
+
+	// Views over the payload are limited to 2 GiB
+	if (SourcePayload.GetSize() > MAX_int32)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Source audio of %s is too large, it is cooked untrimmed."), *SoundWave->GetName());
+		return false;
+	}
+
+	const FString BaseFilename = FPaths::Combine(GetTempDirectory(), FPaths::MakeValidFileName(SoundWave->GetPathName(), TEXT('_')));
+	const FString SourcePath = BaseFilename + TEXT(".wav");
+	const FString TrimmedPath = BaseFilename + TEXT("_trimmed.wav");
+
+	ON_SCOPE_EXIT
+	{
+		UAudioTrimmerUtilsLibrary::DeleteTempWavFile(SourcePath);
+		UAudioTrimmerUtilsLibrary::DeleteTempWavFile(TrimmedPath);
+	};
+
+	const TConstArrayView<uint8> SourceBytes(static_cast<const uint8*>(SourcePayload.GetData()), static_cast<int32>(SourcePayload.GetSize()));
+	FAudioTrimmerWavHeader Header;
+	if (!FFileHelper::SaveArrayToFile(SourceBytes, *SourcePath)
+		|| !FAudioTrimmerWav::ReadHeader(SourcePath, Header)
+		|| !Header.IsUncompressed())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("%s has no uncompressed WAV source, it is cooked untrimmed."), *SoundWave->GetName());
+		return false;
+	}
+
+	FAudioTrimmerFrameRange FrameRange(FMath::RoundToInt64(AssetPlan.StartTimeMs / 1000.0 * Header.SampleRate), FMath::RoundToInt64(AssetPlan.EndTimeMs / 1000.0 * Header.SampleRate));
+	TArray<uint8> TrimmedBytes;
+	if (!UAudioTrimmerUtilsLibrary::TrimAudioFrames(SourcePath, TrimmedPath, FrameRange, LexToString(SoundWave->RawData.GetPayloadId()))
+		|| !FFileHelper::LoadFileToArray(TrimmedBytes, *TrimmedPath))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Trimming audio failed for %s, it is cooked untrimmed."), *SoundWave->GetName());
+		return false;
+	}
+
+	// Platform data is built later from the new payload, the package on disk is never saved
+	if (!UAudioTrimmerUtilsLibrary::SetSoundWavePayload(SoundWave, TrimmedBytes))
+	{
+		return false;
+	}
+
+	Usage->TrimStartTimeSec = static_cast<double>(FrameRange.StartFrame) / Header.SampleRate;
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Cook-time trimmed %s: %.2f MB -> %.2f MB"), *SoundWave->GetName(), SourceBytes.Num() / (1024.f * 1024.f), TrimmedBytes.Num() / (1024.f * 1024.f));
+	return true;
+}
+
+// Rebases all audio sections of the level sequence onto their trimmed sound waves
+void FAudioTrimmerCookTrimmer::RebaseLevelSequence(ULevelSequence* LevelSequence)
+{
+	TArray<UMovieSceneAudioSection*> AudioSections;
+	UAudioTrimmerUtilsLibrary::GetSectionRanges(LevelSequence).GetKeys(AudioSections);
+	for (UMovieSceneAudioSection* AudioSection : AudioSections)
+	{
+		// Sections of sub-sequences are reached from every parent, but rebased only once
+		if (ProcessedObjects.Contains(AudioSection))
+		{
+			continue;
+		}
+
+		// Sound waves are loaded as dependencies of the sequence, but might not be trimmed yet
+		USoundWave* SoundWave = Cast<USoundWave>(AudioSection->GetSound());
+		if (!SoundWave
+			|| !TrimSoundWave(SoundWave))
+		{
+			continue;
+		}
+
+		ProcessedObjects.Add(AudioSection);
+		const FSoundUsage& Usage = UsageBySound.FindChecked(SoundWave->GetPathName());
+		UAudioTrimmerUtilsLibrary::RebaseStartFrameOffsetBySeconds(AudioSection, Usage.TrimStartTimeSec);
+	}
+}
+
+// Returns the folder for temporary files of the cook trimmer
+FString FAudioTrimmerCookTrimmer::GetTempDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AudioTrimmer"), TEXT("Cook"));
+}
@@ -0,0 +1,340 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerDsp.h"
+//---
+#include "AudioTrimmerUtilsLibrary.h"
+#include "AudioTrimmerWav.h"
+
+// Returns the largest absolute difference between the left and right channel of interleaved stereo samples
+float FAudioTrimmerDsp::GetMaxStereoDifference(TConstArrayView<float> InterleavedStereo)
+{
+	const int32 NumSamples = InterleavedStereo.Num() & ~1;
+	const int32 NumVectorized = NumSamples & ~3;
+	const float* Samples = InterleavedStereo.GetData();
+
+	// Each register holds two frames: L0 R0 L1 R1, swapping the pairs gives R0 L0 R1 L1
+	VectorRegister4Float MaxDifference = VectorZeroFloat();
+	for (int32 Index = 0; Index < NumVectorized; Index += 4)
+	{
+		const VectorRegister4Float Frames = VectorLoad(Samples + Index);
+		const VectorRegister4Float Swapped = VectorSwizzle(Frames, 1, 0, 3, 2);
+		MaxDifference = VectorMax(MaxDifference, VectorAbs(VectorSubtract(Frames, Swapped)));
+	}
+
+	alignas(16) float Lanes[4];
+	VectorStoreAligned(MaxDifference, Lanes);
+	float Result = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+
+	for (int32 Index = NumVectorized; Index < NumSamples; Index += 2)
+	{
+		Result = FMath::Max(Result, FMath::Abs(Samples[Index] - Samples[Index + 1]));
+	}
+
+	return Result;
+}
+
+// Returns the largest absolute difference between samples at the same positions of two arrays
+float FAudioTrimmerDsp::GetMaxDifference(TConstArrayView<float> SamplesA, TConstArrayView<float> SamplesB)
+{
+	const int32 NumSamples = FMath::Min(SamplesA.Num(), SamplesB.Num());
+	const int32 NumVectorized = NumSamples & ~3;
+	const float* A = SamplesA.GetData();
+	const float* B = SamplesB.GetData();
+
+	VectorRegister4Float MaxDifference = VectorZeroFloat();
+	for (int32 Index = 0; Index < NumVectorized; Index += 4)
+	{
+		MaxDifference = VectorMax(MaxDifference, VectorAbs(VectorSubtract(VectorLoad(A + Index), VectorLoad(B + Index))));
+	}
+
+	alignas(16) float Lanes[4];
+	VectorStoreAligned(MaxDifference, Lanes);
+	float Result = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+
+	for (int32 Index = NumVectorized; Index < NumSamples; ++Index)
+	{
+		Result = FMath::Max(Result, FMath::Abs(A[Index] - B[Index]));
+	}
+
+	return Result;
+}
+
+// Averages interleaved stereo samples into mono, appending them to the output
+void FAudioTrimmerDsp::DownmixStereoToMono(TConstArrayView<float> InterleavedStereo, TArray<float>& OutMono)
+{
+	const int32 NumFrames = InterleavedStereo.Num() / 2;
+	const int32 StartIndex = OutMono.AddUninitialized(NumFrames);
+	const float* Samples = InterleavedStereo.GetData();
+	float* Mono = OutMono.GetData() + StartIndex;
+
+	// Two registers hold four frames, shuffling picks all left and all right samples
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+	const int32 NumVectorized = NumFrames & ~3;
+	for (int32 Frame = 0; Frame < NumVectorized; Frame += 4)
+	{
+		const VectorRegister4Float First = VectorLoad(Samples + Frame * 2);
+		const VectorRegister4Float Second = VectorLoad(Samples + Frame * 2 + 4);
+		const VectorRegister4Float Left = VectorShuffle(First, Second, 0, 2, 0, 2);
+		const VectorRegister4Float Right = VectorShuffle(First, Second, 1, 3, 1, 3);
+		VectorStore(VectorMultiply(VectorAdd(Left, Right), Half), Mono + Frame);
+	}
+
+	for (int32 Frame = NumVectorized; Frame < NumFrames; ++Frame)
+	{
+		Mono[Frame] = (Samples[Frame * 2] + Samples[Frame * 2 + 1]) * 0.5f;
+	}
+}
+
+// Multiplies interleaved samples by a half-cosine ramp, rising from silence or falling into it
+void FAudioTrimmerDsp::ApplyFade(TArrayView<float> InterleavedSamples, int32 NumChannels, int64 FadeStartFrame, int64 FadeLength, bool bFadeIn)
+{
+	if (NumChannels <= 0 || FadeLength <= 0)
+	{
+		return;
+	}
+
+	// Expand the per-frame gains to every channel, so samples are multiplied four at a time
+	constexpr int32 BlockSize = 256;
+	alignas(16) float Gains[BlockSize];
+
+	const int32 NumSamples = InterleavedSamples.Num();
+	float* Samples = InterleavedSamples.GetData();
+
+	for (int32 BlockStart = 0; BlockStart < NumSamples; BlockStart += BlockSize)
+	{
+		const int32 BlockNum = FMath::Min(BlockSize, NumSamples - BlockStart);
+		for (int32 Index = 0; Index < BlockNum; ++Index)
+		{
+			const int64 Frame = FadeStartFrame + (BlockStart + Index) / NumChannels;
+			const float Alpha = FMath::Clamp(static_cast<float>(Frame) / FadeLength, 0.0f, 1.0f);
+			const float Gain = 0.5f - 0.5f * FMath::Cos(UE_PI * Alpha);
+			Gains[Index] = bFadeIn ? Gain : 1.0f - Gain;
+		}
+
+		const int32 NumVectorized = BlockNum & ~3;
+		for (int32 Index = 0; Index < NumVectorized; Index += 4)
+		{
+			float* Sample = Samples + BlockStart + Index;
+			VectorStore(VectorMultiply(VectorLoad(Sample), VectorLoadAligned(Gains + Index)), Sample);
+		}
+
+		for (int32 Index = NumVectorized; Index < BlockNum; ++Index)
+		{
+			Samples[BlockStart + Index] *= Gains[Index];
+		}
+	}
+}
+
+// Moves both cut points of the range outwards to the closest zero crossing of the summed channels
+void FAudioTrimmerDsp::SnapToZeroCrossings(const FString& FilePath, FAudioTrimmerFrameRange& InOutFrameRange, int64 WindowFrames)
+{
+	FAudioTrimmerWavHeader Header;
+	if (WindowFrames <= 0
+		|| !FAudioTrimmerWav::ReadHeader(FilePath, Header)
+		|| !Header.IsUncompressed())
+	{
+		return;
+	}
+
+	const int64 NumFrames = Header.GetNumFrames();
+	if (InOutFrameRange.IsEmpty()
+		|| InOutFrameRange.StartFrame < 0
+		|| InOutFrameRange.StartFrame >= NumFrames)
+	{
+		return;
+	}
+
+	const int32 NumChannels = Header.NumChannels;
+	TArray<float> Samples;
+
+	// Returns the sum of all channels of the frame, the sign of the sum decides where the crossing is
+	auto GetFrameSum = [&Samples, NumChannels](int64 FrameIndex)
+	{
+		float Sum = 0.0f;
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Sum += Samples[FrameIndex * NumChannels + Channel];
+		}
+		return Sum;
+	};
+
+	auto IsCrossing = [&GetFrameSum](int64 FrameIndex)
+	{
+		const float Previous = GetFrameSum(FrameIndex - 1);
+		const float Current = GetFrameSum(FrameIndex);
+		return Current == 0.0f || (Previous < 0.0f) != (Current < 0.0f);
+	};
+
+	// Start moves backwards: the first kept frame is the one right after the crossing
+	if (InOutFrameRange.StartFrame > 0)
+	{
+		const FAudioTrimmerFrameRange Window = FAudioTrimmerWav::ReadFrames(FilePath, Header, {InOutFrameRange.StartFrame - WindowFrames - 1, InOutFrameRange.StartFrame + 1}, Samples);
+		// The window is clamped to the data, so the search never starts past its last frame
+		const int64 FirstFrame = FMath::Min(InOutFrameRange.StartFrame, Window.EndFrame - 1);
+		for (int64 Frame = FirstFrame; Frame > Window.StartFrame; --Frame)
+		{
+			if (IsCrossing(Frame - Window.StartFrame))
+			{
+				InOutFrameRange.StartFrame = Frame;
+				break;
+			}
+		}
+	}
+
+	// End moves forwards: the cut happens right before the frame after the crossing
+	if (InOutFrameRange.EndFrame < NumFrames)
+	{
+		const FAudioTrimmerFrameRange Window = FAudioTrimmerWav::ReadFrames(FilePath, Header, {InOutFrameRange.EndFrame - 1, InOutFrameRange.EndFrame + WindowFrames}, Samples);
+		for (int64 Frame = InOutFrameRange.EndFrame; Frame < Window.EndFrame; ++Frame)
+		{
+			if (Frame > Window.StartFrame && IsCrossing(Frame - Window.StartFrame))
+			{
+				InOutFrameRange.EndFrame = Frame;
+				break;
+			}
+		}
+	}
+}
+
+// Fades in the beginning and fades out the end of the given WAV file in place
+bool FAudioTrimmerDsp::ApplyEdgeFades(const FString& FilePath, int64 FadeInFrames, int64 FadeOutFrames)
+{
+	FAudioTrimmerWavHeader Header;
+	if (!FAudioTrimmerWav::ReadHeader(FilePath, Header))
+	{
+		return false;
+	}
+
+	const int64 TotalFrames = Header.GetNumFrames();
+	const int32 NumChannels = Header.NumChannels;
+
+	// Short sounds are faded over at most half of their length from each side
+	FadeInFrames = FMath::Min(FadeInFrames, TotalFrames / 2);
+	FadeOutFrames = FMath::Min(FadeOutFrames, TotalFrames / 2);
+
+	bool bSuccess = true;
+	if (FadeInFrames > 0)
+	{
+		bSuccess &= FAudioTrimmerWav::ModifyFrames(FilePath, {0, FadeInFrames}, [&](TArrayView<float> Samples, int64 StartFrame)
+		{
+			ApplyFade(Samples, NumChannels, StartFrame, FadeInFrames, /*bFadeIn*/true);
+		});
+	}
+
+	if (FadeOutFrames > 0)
+	{
+		const int64 FadeOutStart = TotalFrames - FadeOutFrames;
+		bSuccess &= FAudioTrimmerWav::ModifyFrames(FilePath, {FadeOutStart, TotalFrames}, [&](TArrayView<float> Samples, int64 StartFrame)
+		{
+			// The last frame reaches the silence
+			ApplyFade(Samples, NumChannels, StartFrame - FadeOutStart + 1, FadeOutFrames, /*bFadeIn*/false);
+		});
+	}
+
+	return bSuccess;
+}
+
+// Returns true if both channels of the given stereo WAV file are identical within the tolerance
+bool FAudioTrimmerDsp::IsFakeStereo(const FString& FilePath, float Tolerance)
+{
+	FAudioTrimmerWavHeader Header;
+	if (!FAudioTrimmerWav::ReadHeader(FilePath, Header)
+		|| Header.NumChannels != 2)
+	{
+		return false;
+	}
+
+	// Stops reading at the first chunk where channels differ
+	return FAudioTrimmerWav::ForEachSampleChunk(FilePath, Header, [Tolerance](TConstArrayView<float> InterleavedSamples)
+	{
+		return GetMaxStereoDifference(InterleavedSamples) <= Tolerance;
+	});
+}
+
+// Writes the average of both channels of the given stereo WAV file into a new mono WAV file of the same sample format
+bool FAudioTrimmerDsp::DownmixFileToMono(const FString& InputPath, const FString& OutputPath)
+{
+	FAudioTrimmerWavHeader InputHeader;
+	if (!FAudioTrimmerWav::ReadHeader(InputPath, InputHeader)
+		|| InputHeader.NumChannels != 2)
+	{
+		return false;
+	}
+
+	const FAudioTrimmerWavHeader OutputHeader = FAudioTrimmerWavHeader::Make(1, InputHeader.SampleRate, InputHeader.GetBytesPerSample() * 8, InputHeader.IsFloat());
+	FAudioTrimmerWavWriter Writer;
+	if (!Writer.Open(OutputPath, OutputHeader, InputHeader.GetNumFrames()))
+	{
+		return false;
+	}
+
+	TArray<float> MonoSamples;
+	const bool bRead = FAudioTrimmerWav::ForEachSampleChunk(InputPath, InputHeader, [&](TConstArrayView<float> InterleavedSamples)
+	{
+		MonoSamples.Reset();
+		DownmixStereoToMono(InterleavedSamples, MonoSamples);
+		return Writer.Write(MonoSamples);
+	});
+
+	return bRead && Writer.Close();
+}
+
+// Returns true if the trimmed WAV file holds exactly the given frames of the source WAV file
+bool FAudioTrimmerDsp::VerifyTrimmedFile(const FString& SourcePath, const FString& TrimmedPath, const FAudioTrimmerFrameRange& SourceRange, int64 IgnoredHeadFrames, int64 IgnoredTailFrames)
+{
+	FAudioTrimmerWavHeader SourceHeader;
+	FAudioTrimmerWavHeader TrimmedHeader;
+	if (!FAudioTrimmerWav::ReadHeader(SourcePath, SourceHeader)
+		|| !FAudioTrimmerWav::ReadHeader(TrimmedPath, TrimmedHeader)
+		|| SourceHeader.NumChannels != TrimmedHeader.NumChannels
+		|| SourceHeader.SampleRate != TrimmedHeader.SampleRate
+		|| TrimmedHeader.GetNumFrames() != SourceRange.Num()
+		|| SourceRange.EndFrame > SourceHeader.GetNumFrames())
+	{
+		return false;
+	}
+
+	// Frames of the trimmed file to compare, the source frames are shifted by the start of the range
+	const FAudioTrimmerFrameRange ComparedRange(FMath::Max<int64>(IgnoredHeadFrames, 0), SourceRange.Num() - FMath::Max<int64>(IgnoredTailFrames, 0));
+	if (ComparedRange.IsEmpty())
+	{
+		return true;
+	}
+
+	const FAudioTrimmerFrameRange SourceComparedRange(SourceRange.StartFrame + ComparedRange.StartFrame, SourceRange.StartFrame + ComparedRange.EndFrame);
+
+	// Samples are copied verbatim, so the same format means the same bytes
+	const bool bSameFormat = SourceHeader.BlockAlign == TrimmedHeader.BlockAlign
+		&& SourceHeader.IsFloat() == TrimmedHeader.IsFloat();
+
+	FAudioTrimmerMappedWav MappedSource;
+	FAudioTrimmerMappedWav MappedTrimmed;
+	if (bSameFormat
+		&& MappedSource.Open(SourcePath)
+		&& MappedTrimmed.Open(TrimmedPath))
+	{
+		const TConstArrayView64<uint8> SourceBytes = MappedSource.GetFrames(SourceComparedRange);
+		const TConstArrayView64<uint8> TrimmedBytes = MappedTrimmed.GetFrames(ComparedRange);
+		return SourceBytes.Num() == TrimmedBytes.Num()
+			&& FMemory::Memcmp(SourceBytes.GetData(), TrimmedBytes.GetData(), SourceBytes.Num()) == 0;
+	}
+
+	// Decode both files through two buffers of at most StreamChunkSize bytes in total
+	const int64 ChunkFrames = FMath::Max<int64>(FAudioTrimmerWav::StreamChunkSize / (2 * sizeof(float) * SourceHeader.NumChannels), 1);
+	TArray<float> SourceSamples;
+	TArray<float> TrimmedSamples;
+	for (int64 Frame = ComparedRange.StartFrame; Frame < ComparedRange.EndFrame; Frame += ChunkFrames)
+	{
+		const int64 NumFrames = FMath::Min(ChunkFrames, ComparedRange.EndFrame - Frame);
+		const FAudioTrimmerFrameRange SourceRead = FAudioTrimmerWav::ReadFrames(SourcePath, SourceHeader, {SourceRange.StartFrame + Frame, SourceRange.StartFrame + Frame + NumFrames}, SourceSamples);
+		const FAudioTrimmerFrameRange TrimmedRead = FAudioTrimmerWav::ReadFrames(TrimmedPath, TrimmedHeader, {Frame, Frame + NumFrames}, TrimmedSamples);
+		if (SourceRead.Num() != NumFrames
+			|| TrimmedRead.Num() != NumFrames
+			|| GetMaxDifference(SourceSamples, TrimmedSamples) > 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,155 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerJournal.h"
+//---
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Opens the journal of the given run, loading entries left from a previous interrupted run
+FAudioTrimmerJournal::FAudioTrimmerJournal(const FString& RunName)
+{
+	const FString FileName = FString::Printf(TEXT("%s_%08X.journal"), *FPaths::GetBaseFilename(RunName), GetTypeHash(RunName));
+	FilePath = FPaths::Combine(GetJournalDirectory(), FileName);
+
+	Load();
+}
+
+// Returns the folder where all journals are stored
+FString FAudioTrimmerJournal::GetJournalDirectory()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AudioTrimmer"), TEXT("Journals")));
+}
+
+// Returns the latest state of the given asset, or None if the asset is not in the journal
+EAudioTrimmerJournalState FAudioTrimmerJournal::GetState(const FString& AssetPath) const
+{
+	FScopeLock Lock(&CriticalSection);
+	const FEntry* Entry = Entries.Find(AssetPath);
+	return Entry ? Entry->State : EAudioTrimmerJournalState::None;
+}
+
+// Returns the value recorded for the given asset, or empty string if it was never recorded
+FString FAudioTrimmerJournal::GetValue(const FString& AssetPath, const FString& Key) const
+{
+	FScopeLock Lock(&CriticalSection);
+	const FEntry* Entry = Entries.Find(AssetPath);
+	const FString* Value = Entry ? Entry->Values.Find(Key) : nullptr;
+	return Value ? *Value : FString();
+}
+
+// Appends a new state of the asset to the journal and flushes it to disk
+void FAudioTrimmerJournal::Append(const FString& AssetPath, EAudioTrimmerJournalState State, const TMap<FString, FString>& Values)
+{
+	// Assets processed in parallel append to the same file, lines must not interleave
+	FScopeLock Lock(&CriticalSection);
+	FEntry& Entry = Entries.FindOrAdd(AssetPath);
+	Entry.State = State;
+
+	// One line per state change: State<TAB>AssetPath<TAB>Key=Value...
+	FString Line = FString::Printf(TEXT("%s\t%s"), LexToString(State), *AssetPath);
+	for (const TTuple<FString, FString>& It : Values)
+	{
+		Entry.Values.Add(It.Key, It.Value);
+		Line += FString::Printf(TEXT("\t%s=%s"), *It.Key, *It.Value);
+	}
+	Line += LINE_TERMINATOR;
+
+	// Every line is written with its own file handle, so it reaches the disk even if the editor crashes right after
+	if (!FFileHelper::SaveStringToFile(Line, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to write to the journal: %s"), *FilePath);
+	}
+}
+
+// Returns true if every asset in the journal reached the Committed state
+bool FAudioTrimmerJournal::IsEveryAssetCommitted() const
+{
+	FScopeLock Lock(&CriticalSection);
+	for (const TTuple<FString, FEntry>& It : Entries)
+	{
+		if (It.Value.State != EAudioTrimmerJournalState::Committed)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Deletes the journal file, is called when the whole run finished successfully
+void FAudioTrimmerJournal::Complete()
+{
+	FScopeLock Lock(&CriticalSection);
+	Entries.Empty();
+	bResumed = false;
+	IFileManager::Get().Delete(*FilePath, false, true, true);
+}
+
+// Returns the name of the given state as it is written to the journal
+const TCHAR* FAudioTrimmerJournal::LexToString(EAudioTrimmerJournalState State)
+{
+	switch (State)
+	{
+	case EAudioTrimmerJournalState::Planned: return TEXT("Planned");
+	case EAudioTrimmerJournalState::Exported: return TEXT("Exported");
+	case EAudioTrimmerJournalState::Trimmed: return TEXT("Trimmed");
+	case EAudioTrimmerJournalState::Reimported: return TEXT("Reimported");
+	case EAudioTrimmerJournalState::Committed: return TEXT("Committed");
+	default: return TEXT("None");
+	}
+}
+
+// Reads all entries from the journal file
+void FAudioTrimmerJournal::Load()
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+	{
+		return;
+	}
+
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Fields;
+		Line.ParseIntoArray(Fields, TEXT("\t"));
+		if (Fields.Num() < 2)
+		{
+			// Last line might be cut by the crash
+			continue;
+		}
+
+		EAudioTrimmerJournalState State = EAudioTrimmerJournalState::None;
+		for (uint8 StateIndex = 0; StateIndex <= static_cast<uint8>(EAudioTrimmerJournalState::Committed); ++StateIndex)
+		{
+			if (Fields[0] == LexToString(static_cast<EAudioTrimmerJournalState>(StateIndex)))
+			{
+				State = static_cast<EAudioTrimmerJournalState>(StateIndex);
+				break;
+			}
+		}
+
+		if (State == EAudioTrimmerJournalState::None)
+		{
+			continue;
+		}
+
+		FEntry& Entry = Entries.FindOrAdd(Fields[1]);
+		Entry.State = State;
+		for (int32 FieldIndex = 2; FieldIndex < Fields.Num(); ++FieldIndex)
+		{
+			FString Key, Value;
+			if (Fields[FieldIndex].Split(TEXT("="), &Key, &Value))
+			{
+				Entry.Values.Add(Key, Value);
+			}
+		}
+	}
+
+	bResumed = Entries.Num() > 0;
+	if (bResumed)
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Resuming interrupted run from the journal: %s, %d assets recorded."), *FilePath, Entries.Num());
+	}
+}
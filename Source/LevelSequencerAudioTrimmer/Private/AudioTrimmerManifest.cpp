@@ -0,0 +1,280 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerManifest.h"
+//---
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "LevelSequence.h"
+#include "AssetRegistry/IAssetRegistry.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Sections/MovieSceneAudioSection.h"
+#include "Serialization/MemoryWriter.h"
+#include "Sound/SoundWave.h"
+
+namespace AudioTrimmerManifest
+{
+	/** 'ATUM' written at the beginning of the file. */
+	constexpr uint32 Magic = 0x4D555441;
+
+	/** Increase when the layout changes, older manifests are rebuilt from scratch. */
+	constexpr int32 Version = 1;
+}
+
+// Returns the path where the manifest of the project is stored
+FString FAudioTrimmerManifest::GetDefaultFilePath()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AudioTrimmer"), TEXT("UsageManifest.bin")));
+}
+
+// Reads the manifest from the given file, replacing current entries
+bool FAudioTrimmerManifest::Load(const FString& FilePath)
+{
+	Sequences.Empty();
+
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	*Reader << Magic << Version;
+	if (Magic != AudioTrimmerManifest::Magic
+		|| Version != AudioTrimmerManifest::Version)
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Usage manifest has an unknown version, it will be rebuilt: %s"), *FilePath);
+		return false;
+	}
+
+	// Paths are stored once in a table, entries refer to them by index
+	TArray<FString> Strings;
+	*Reader << Strings;
+
+	auto ReadString = [&Reader, &Strings]()
+	{
+		int32 Index = INDEX_NONE;
+		*Reader << Index;
+		return Strings.IsValidIndex(Index) ? Strings[Index] : FString();
+	};
+
+	int32 NumSequences = 0;
+	*Reader << NumSequences;
+	for (int32 SequenceIndex = 0; SequenceIndex < NumSequences && !Reader->IsError(); ++SequenceIndex)
+	{
+		const FString PackageName = ReadString();
+		FAudioTrimmerSequenceUsage& SequenceUsage = Sequences.Add(PackageName);
+		*Reader << SequenceUsage.Timestamp << SequenceUsage.FileSize;
+
+		int32 NumSections = 0;
+		*Reader << NumSections;
+		for (int32 SectionIndex = 0; SectionIndex < NumSections && !Reader->IsError(); ++SectionIndex)
+		{
+			FAudioTrimmerSectionUsage& SectionUsage = SequenceUsage.Sections.AddDefaulted_GetRef();
+			SectionUsage.SectionPath = ReadString();
+			SectionUsage.SoundWavePath = ReadString();
+			*Reader << SectionUsage.SampleRate << SectionUsage.FrameRange.StartFrame << SectionUsage.FrameRange.EndFrame;
+		}
+	}
+
+	if (Reader->IsError())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Usage manifest is corrupted, it will be rebuilt: %s"), *FilePath);
+		Sequences.Empty();
+		return false;
+	}
+
+	return true;
+}
+
+// Writes the manifest to the given file
+bool FAudioTrimmerManifest::Save(const FString& FilePath) const
+{
+	TArray<FString> Strings;
+	TMap<FString, int32> StringIndices;
+	auto GetStringIndex = [&Strings, &StringIndices](const FString& String)
+	{
+		int32& Index = StringIndices.FindOrAdd(String, INDEX_NONE);
+		if (Index == INDEX_NONE)
+		{
+			Index = Strings.Add(String);
+		}
+		return Index;
+	};
+
+	// Body is written first, so the table of strings it refers to is complete
+	TArray<uint8> Body;
+	FMemoryWriter BodyWriter(Body);
+
+	int32 NumSequences = Sequences.Num();
+	BodyWriter << NumSequences;
+	for (const TTuple<FString, FAudioTrimmerSequenceUsage>& It : Sequences)
+	{
+		FAudioTrimmerSequenceUsage SequenceUsage = It.Value;
+		int32 PackageIndex = GetStringIndex(It.Key);
+		int32 NumSections = SequenceUsage.Sections.Num();
+		BodyWriter << PackageIndex << SequenceUsage.Timestamp << SequenceUsage.FileSize << NumSections;
+
+		for (FAudioTrimmerSectionUsage& SectionUsage : SequenceUsage.Sections)
+		{
+			int32 SectionIndex = GetStringIndex(SectionUsage.SectionPath);
+			int32 SoundIndex = GetStringIndex(SectionUsage.SoundWavePath);
+			BodyWriter << SectionIndex << SoundIndex << SectionUsage.SampleRate << SectionUsage.FrameRange.StartFrame << SectionUsage.FrameRange.EndFrame;
+		}
+	}
+
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!Writer)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to write usage manifest: %s"), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = AudioTrimmerManifest::Magic;
+	int32 Version = AudioTrimmerManifest::Version;
+	*Writer << Magic << Version << Strings;
+	Writer->Serialize(Body.GetData(), Body.Num());
+
+	return Writer->Close();
+}
+
+// Rescans level sequences whose package files were added or changed since the last refresh and drops deleted ones
+int32 FAudioTrimmerManifest::Refresh(const FString& ContentPath)
+{
+	IAssetRegistry::GetChecked().SearchAllAssets(/*bSynchronousSearch*/true);
+
+	int32 NumChanged = 0;
+	for (const FAssetData& AssetData : CollectChangedSequences(ContentPath, NumChanged))
+	{
+		// Only changed sequences are loaded
+		if (const ULevelSequence* LevelSequence = Cast<ULevelSequence>(AssetData.GetAsset()))
+		{
+			UpdateSequence(LevelSequence);
+			++NumChanged;
+		}
+
+		// Only usage is kept, so sequences that were already read can be unloaded
+		UAudioTrimmerUtilsLibrary::CollectGarbageIfOverBudget();
+	}
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Usage manifest refreshed: %d level sequences, %d changed."), Sequences.Num(), NumChanged);
+	return NumChanged;
+}
+
+// Drops level sequences that were deleted or renamed, and returns the ones whose package files were added or changed since the last refresh
+TArray<FAssetData> FAudioTrimmerManifest::CollectChangedSequences(const FString& ContentPath, int32& OutNumRemoved)
+{
+	FARFilter Filter;
+	Filter.ClassPaths.Add(ULevelSequence::StaticClass()->GetClassPathName());
+	Filter.PackagePaths.Add(*ContentPath);
+	Filter.bRecursivePaths = true;
+	Filter.bRecursiveClasses = true;
+
+	TArray<FAssetData> LevelSequences;
+	IAssetRegistry::GetChecked().GetAssets(Filter, LevelSequences);
+
+	TArray<FAssetData> ChangedSequences;
+	TSet<FString> FoundPackages;
+	for (const FAssetData& AssetData : LevelSequences)
+	{
+		const FString PackageName = AssetData.PackageName.ToString();
+		FoundPackages.Add(PackageName);
+
+		FDateTime Timestamp;
+		int64 FileSize = 0;
+		GetPackageFileState(PackageName, Timestamp, FileSize);
+
+		const FAudioTrimmerSequenceUsage* SequenceUsage = Sequences.Find(PackageName);
+		if (SequenceUsage
+			&& SequenceUsage->Timestamp == Timestamp
+			&& SequenceUsage->FileSize == FileSize)
+		{
+			continue;
+		}
+
+		ChangedSequences.Add(AssetData);
+	}
+
+	// Drop sequences that were deleted or renamed, the trailing slash keeps '/Game/FooBar' out of '/Game/Foo'
+	const FString ContentFolder = ContentPath / TEXT("");
+	OutNumRemoved = 0;
+	for (auto It = Sequences.CreateIterator(); It; ++It)
+	{
+		if (It.Key().StartsWith(ContentFolder)
+			&& !FoundPackages.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+			++OutNumRemoved;
+		}
+	}
+
+	return ChangedSequences;
+}
+
+// Replaces the usages of the given level sequence with its current audio sections
+void FAudioTrimmerManifest::UpdateSequence(const ULevelSequence* LevelSequence)
+{
+	if (!LevelSequence)
+	{
+		return;
+	}
+
+	const FString PackageName = LevelSequence->GetPackage()->GetName();
+	FAudioTrimmerSequenceUsage& SequenceUsage = Sequences.FindOrAdd(PackageName);
+	GetPackageFileState(PackageName, SequenceUsage.Timestamp, SequenceUsage.FileSize);
+	SequenceUsage.Sections.Reset();
+
+	for (const TTuple<UMovieSceneAudioSection*, TRange<FFrameNumber>>& It : UAudioTrimmerUtilsLibrary::GetSectionRanges(LevelSequence))
+	{
+		const UMovieSceneAudioSection* AudioSection = It.Key;
+		const USoundWave* SoundWave = Cast<USoundWave>(AudioSection->GetSound());
+		if (!SoundWave)
+		{
+			continue;
+		}
+
+		int32 StartTimeMs = 0;
+		int32 EndTimeMs = 0;
+		UAudioTrimmerUtilsLibrary::CalculateSectionTrimTimes(AudioSection, It.Value, StartTimeMs, EndTimeMs);
+
+		FAudioTrimmerSectionUsage& SectionUsage = SequenceUsage.Sections.AddDefaulted_GetRef();
+		SectionUsage.SectionPath = AudioSection->GetPathName();
+		SectionUsage.SoundWavePath = SoundWave->GetPathName();
+		// Without a known sample rate, frames are counted in milliseconds
+		const int32 SampleRate = static_cast<int32>(SoundWave->GetSampleRateForCurrentPlatform());
+		SectionUsage.SampleRate = SampleRate > 0 ? SampleRate : 1000;
+		SectionUsage.FrameRange = FAudioTrimmerFrameRange(static_cast<int64>(StartTimeMs) * SectionUsage.SampleRate / 1000, static_cast<int64>(EndTimeMs) * SectionUsage.SampleRate / 1000);
+	}
+}
+
+// Returns usages of all level sequences grouped by the path name of their sound wave
+TMap<FString, TArray<const FAudioTrimmerSectionUsage*>> FAudioTrimmerManifest::GetUsagesBySound() const
+{
+	TMap<FString, TArray<const FAudioTrimmerSectionUsage*>> UsagesBySound;
+	for (const TTuple<FString, FAudioTrimmerSequenceUsage>& It : Sequences)
+	{
+		for (const FAudioTrimmerSectionUsage& SectionUsage : It.Value.Sections)
+		{
+			UsagesBySound.FindOrAdd(SectionUsage.SoundWavePath).Add(&SectionUsage);
+		}
+	}
+	return UsagesBySound;
+}
+
+// Reads the modification time and size of the given package file, returns false if the package does not exist
+bool FAudioTrimmerManifest::GetPackageFileState(const FString& PackageName, FDateTime& OutTimestamp, int64& OutFileSize)
+{
+	FString Filename;
+	if (!FPackageName::DoesPackageExist(PackageName, &Filename))
+	{
+		OutTimestamp = FDateTime::MinValue();
+		OutFileSize = 0;
+		return false;
+	}
+
+	OutTimestamp = IFileManager::Get().GetTimeStamp(*Filename);
+	OutFileSize = IFileManager::Get().FileSize(*Filename);
+	return true;
+}
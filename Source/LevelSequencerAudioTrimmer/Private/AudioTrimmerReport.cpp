@@ -0,0 +1,285 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerReport.h"
+//---
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Starts the report of the given run
+FAudioTrimmerReport::FAudioTrimmerReport(const FString& InRunName)
+	: RunName(InRunName)
+	, StartTime(FDateTime::UtcNow())
+{
+}
+
+// Returns the folder where all reports are stored
+FString FAudioTrimmerReport::GetReportsDirectory()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AudioTrimmer"), TEXT("Reports")));
+}
+
+// Adds the outcome of one sound wave
+void FAudioTrimmerReport::AddAsset(const FAudioTrimmerAssetReport& AssetReport)
+{
+	Assets.Add(AssetReport);
+}
+
+// Adds all assets of another report
+void FAudioTrimmerReport::Append(const FAudioTrimmerReport& Other)
+{
+	Assets.Append(Other.Assets);
+
+	// Merged runs can overlap in time, e.g. parallel workers, so their durations are not summed
+	TotalSeconds = FMath::Max(TotalSeconds, Other.TotalSeconds);
+}
+
+// Stops the clock of the run
+void FAudioTrimmerReport::Finish()
+{
+	TotalSeconds = (FDateTime::UtcNow() - StartTime).GetTotalSeconds();
+}
+
+// Returns sums of all assets
+FAudioTrimmerReport::FTotals FAudioTrimmerReport::GetTotals() const
+{
+	FTotals Totals;
+	Totals.NumAssets = Assets.Num();
+	for (const FAudioTrimmerAssetReport& Asset : Assets)
+	{
+		Totals.NumTrimmed += Asset.Status == EAudioTrimmerAssetStatus::Trimmed ? 1 : 0;
+		Totals.NumSkipped += Asset.Status == EAudioTrimmerAssetStatus::Skipped ? 1 : 0;
+		Totals.NumFailed += Asset.Status == EAudioTrimmerAssetStatus::Failed ? 1 : 0;
+
+		// Untrimmed assets keep their original size
+		const bool bTrimmed = Asset.Status == EAudioTrimmerAssetStatus::Trimmed;
+		Totals.OriginalBytes += Asset.OriginalBytes;
+		Totals.NewBytes += bTrimmed ? Asset.NewBytes : Asset.OriginalBytes;
+		Totals.OriginalDurationSec += Asset.OriginalDurationSec;
+		Totals.NewDurationSec += bTrimmed ? Asset.NewDurationSec : Asset.OriginalDurationSec;
+	}
+	return Totals;
+}
+
+// Writes the report as '.json' and '.html' files next to each other
+FString FAudioTrimmerReport::Save() const
+{
+	// Hash of the full name keeps runs of same-named level sequences from different folders apart
+	const FString FileName = FString::Printf(TEXT("%s_%08X_%s"), *FPaths::GetBaseFilename(RunName), GetTypeHash(RunName), *StartTime.ToString(TEXT("%Y%m%d_%H%M%S")));
+	const FString BasePath = FPaths::Combine(GetReportsDirectory(), FileName);
+
+	if (!SaveJson(BasePath + TEXT(".json"))
+		|| !SaveHtml(BasePath + TEXT(".html")))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to write the run report: %s"), *BasePath);
+		return FString();
+	}
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Run report is written to: %s.html"), *BasePath);
+	return BasePath;
+}
+
+// Writes the report as JSON to the given file
+bool FAudioTrimmerReport::SaveJson(const FString& FilePath) const
+{
+	const FTotals Totals = GetTotals();
+
+	const TSharedRef<FJsonObject> TotalsObject = MakeShared<FJsonObject>();
+	TotalsObject->SetNumberField(TEXT("assets"), Totals.NumAssets);
+	TotalsObject->SetNumberField(TEXT("trimmed"), Totals.NumTrimmed);
+	TotalsObject->SetNumberField(TEXT("skipped"), Totals.NumSkipped);
+	TotalsObject->SetNumberField(TEXT("failed"), Totals.NumFailed);
+	TotalsObject->SetNumberField(TEXT("originalBytes"), Totals.OriginalBytes);
+	TotalsObject->SetNumberField(TEXT("newBytes"), Totals.NewBytes);
+	TotalsObject->SetNumberField(TEXT("savedBytes"), Totals.OriginalBytes - Totals.NewBytes);
+	TotalsObject->SetNumberField(TEXT("originalDurationSec"), Totals.OriginalDurationSec);
+	TotalsObject->SetNumberField(TEXT("newDurationSec"), Totals.NewDurationSec);
+
+	TArray<TSharedPtr<FJsonValue>> AssetValues;
+	for (const FAudioTrimmerAssetReport& Asset : Assets)
+	{
+		const TSharedRef<FJsonObject> AssetObject = MakeShared<FJsonObject>();
+		AssetObject->SetStringField(TEXT("assetPath"), Asset.AssetPath);
+		AssetObject->SetStringField(TEXT("status"), LexToString(Asset.Status));
+		AssetObject->SetStringField(TEXT("reason"), Asset.Reason);
+		AssetObject->SetNumberField(TEXT("originalBytes"), Asset.OriginalBytes);
+		AssetObject->SetNumberField(TEXT("newBytes"), Asset.NewBytes);
+		AssetObject->SetNumberField(TEXT("originalDurationSec"), Asset.OriginalDurationSec);
+		AssetObject->SetNumberField(TEXT("newDurationSec"), Asset.NewDurationSec);
+		AssetObject->SetNumberField(TEXT("usedPercent"), Asset.UsedPercent);
+		AssetObject->SetNumberField(TEXT("exportSeconds"), Asset.ExportSeconds);
+		AssetObject->SetNumberField(TEXT("processSeconds"), Asset.ProcessSeconds);
+		AssetObject->SetNumberField(TEXT("commitSeconds"), Asset.CommitSeconds);
+
+		if (Asset.Stats.bIsValid)
+		{
+			const TSharedRef<FJsonObject> StatsObject = MakeShared<FJsonObject>();
+			StatsObject->SetNumberField(TEXT("peakDbfs"), Asset.Stats.PeakDbfs);
+			StatsObject->SetNumberField(TEXT("rmsDbfs"), Asset.Stats.RmsDbfs);
+			StatsObject->SetNumberField(TEXT("integratedLufs"), Asset.Stats.IntegratedLufs);
+			StatsObject->SetNumberField(TEXT("silencePercent"), Asset.Stats.SilencePercent);
+			AssetObject->SetObjectField(TEXT("stats"), StatsObject);
+		}
+
+		TArray<TSharedPtr<FJsonValue>> NoteValues;
+		for (const FString& Note : Asset.Notes)
+		{
+			NoteValues.Add(MakeShared<FJsonValueString>(Note));
+		}
+		AssetObject->SetArrayField(TEXT("notes"), NoteValues);
+
+		AssetValues.Add(MakeShared<FJsonValueObject>(AssetObject));
+	}
+
+	const TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetStringField(TEXT("runName"), RunName);
+	RootObject->SetStringField(TEXT("startTime"), StartTime.ToIso8601());
+	RootObject->SetNumberField(TEXT("totalSeconds"), TotalSeconds);
+	RootObject->SetObjectField(TEXT("totals"), TotalsObject);
+	RootObject->SetArrayField(TEXT("assets"), AssetValues);
+
+	FString JsonString;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	return FJsonSerializer::Serialize(RootObject, Writer)
+		&& FFileHelper::SaveStringToFile(JsonString, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+// Writes the report as an HTML table to the given file
+bool FAudioTrimmerReport::SaveHtml(const FString& FilePath) const
+{
+	auto Escape = [](const FString& Text)
+	{
+		return Text.Replace(TEXT("&"), TEXT("&amp;")).Replace(TEXT("<"), TEXT("&lt;")).Replace(TEXT(">"), TEXT("&gt;"));
+	};
+
+	auto ToMB = [](int64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	};
+
+	const FTotals Totals = GetTotals();
+
+	FString Html;
+	Html += TEXT("<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>Audio Trimmer Report</title>\n");
+	Html += TEXT("<style>body{font-family:sans-serif}table{border-collapse:collapse}td,th{border:1px solid #ccc;padding:4px 8px;text-align:right}td:first-child,td:nth-child(2),td:last-child{text-align:left}</style>\n");
+	Html += TEXT("</head><body>\n");
+	Html += FString::Printf(TEXT("<h1>%s</h1>\n"), *Escape(RunName));
+	Html += FString::Printf(TEXT("<p>Started %s, took %.1f s.</p>\n"), *StartTime.ToString(), TotalSeconds);
+	Html += FString::Printf(TEXT("<p>%d sounds: %d trimmed, %d skipped, %d failed. Size %.2f MB &rarr; %.2f MB (saved %.2f MB). Duration %.1f s &rarr; %.1f s.</p>\n"),
+	                        Totals.NumAssets, Totals.NumTrimmed, Totals.NumSkipped, Totals.NumFailed,
+	                        ToMB(Totals.OriginalBytes), ToMB(Totals.NewBytes), ToMB(Totals.OriginalBytes - Totals.NewBytes),
+	                        Totals.OriginalDurationSec, Totals.NewDurationSec);
+
+	Html += TEXT("<table>\n<tr><th>Sound</th><th>Status</th><th>Original MB</th><th>New MB</th><th>Original s</th><th>New s</th><th>Used %</th><th>Export s</th><th>Process s</th><th>Commit s</th><th>Peak dBFS</th><th>RMS dBFS</th><th>LUFS</th><th>Silence %</th><th>Notes</th></tr>\n");
+	for (const FAudioTrimmerAssetReport& Asset : Assets)
+	{
+		FString Notes = Asset.Reason;
+		for (const FString& Note : Asset.Notes)
+		{
+			Notes += (Notes.IsEmpty() ? TEXT("") : TEXT("; ")) + Note;
+		}
+
+		// Sounds that were not trimmed were not measured either
+		const FString StatsCells = Asset.Stats.bIsValid
+			? FString::Printf(TEXT("<td>%.1f</td><td>%.1f</td><td>%.1f</td><td>%.1f</td>"), Asset.Stats.PeakDbfs, Asset.Stats.RmsDbfs, Asset.Stats.IntegratedLufs, Asset.Stats.SilencePercent)
+			: TEXT("<td></td><td></td><td></td><td></td>");
+
+		Html += FString::Printf(TEXT("<tr><td>%s</td><td>%s</td><td>%.2f</td><td>%.2f</td><td>%.2f</td><td>%.2f</td><td>%.1f</td><td>%.2f</td><td>%.2f</td><td>%.2f</td>%s<td>%s</td></tr>\n"),
+		                        *Escape(Asset.AssetPath), LexToString(Asset.Status), ToMB(Asset.OriginalBytes), ToMB(Asset.NewBytes),
+		                        Asset.OriginalDurationSec, Asset.NewDurationSec, Asset.UsedPercent,
+		                        Asset.ExportSeconds, Asset.ProcessSeconds, Asset.CommitSeconds, *StatsCells, *Escape(Notes));
+	}
+	Html += TEXT("</table>\n</body></html>\n");
+
+	return FFileHelper::SaveStringToFile(Html, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+// Reads a report previously written by SaveJson
+bool FAudioTrimmerReport::LoadJson(const FString& FilePath)
+{
+	FString JsonString;
+	TSharedPtr<FJsonObject> RootObject;
+	if (!FFileHelper::LoadFileToString(JsonString, *FilePath)
+		|| !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonString), RootObject)
+		|| !RootObject.IsValid())
+	{
+		return false;
+	}
+
+	RootObject->TryGetStringField(TEXT("runName"), RunName);
+	RootObject->TryGetNumberField(TEXT("totalSeconds"), TotalSeconds);
+
+	FString StartTimeString;
+	if (RootObject->TryGetStringField(TEXT("startTime"), StartTimeString))
+	{
+		FDateTime::ParseIso8601(*StartTimeString, StartTime);
+	}
+
+	Assets.Reset();
+	const TArray<TSharedPtr<FJsonValue>>* AssetValues = nullptr;
+	if (!RootObject->TryGetArrayField(TEXT("assets"), AssetValues))
+	{
+		return true;
+	}
+
+	for (const TSharedPtr<FJsonValue>& AssetValue : *AssetValues)
+	{
+		const TSharedPtr<FJsonObject> AssetObject = AssetValue->AsObject();
+		if (!AssetObject.IsValid())
+		{
+			continue;
+		}
+
+		FAudioTrimmerAssetReport& Asset = Assets.AddDefaulted_GetRef();
+		AssetObject->TryGetStringField(TEXT("assetPath"), Asset.AssetPath);
+		AssetObject->TryGetStringField(TEXT("reason"), Asset.Reason);
+		AssetObject->TryGetNumberField(TEXT("originalBytes"), Asset.OriginalBytes);
+		AssetObject->TryGetNumberField(TEXT("newBytes"), Asset.NewBytes);
+		AssetObject->TryGetNumberField(TEXT("originalDurationSec"), Asset.OriginalDurationSec);
+		AssetObject->TryGetNumberField(TEXT("newDurationSec"), Asset.NewDurationSec);
+		AssetObject->TryGetNumberField(TEXT("usedPercent"), Asset.UsedPercent);
+		AssetObject->TryGetNumberField(TEXT("exportSeconds"), Asset.ExportSeconds);
+		AssetObject->TryGetNumberField(TEXT("processSeconds"), Asset.ProcessSeconds);
+		AssetObject->TryGetNumberField(TEXT("commitSeconds"), Asset.CommitSeconds);
+		AssetObject->TryGetStringArrayField(TEXT("notes"), Asset.Notes);
+
+		const TSharedPtr<FJsonObject>* StatsObject = nullptr;
+		if (AssetObject->TryGetObjectField(TEXT("stats"), StatsObject))
+		{
+			Asset.Stats.bIsValid = true;
+			(*StatsObject)->TryGetNumberField(TEXT("peakDbfs"), Asset.Stats.PeakDbfs);
+			(*StatsObject)->TryGetNumberField(TEXT("rmsDbfs"), Asset.Stats.RmsDbfs);
+			(*StatsObject)->TryGetNumberField(TEXT("integratedLufs"), Asset.Stats.IntegratedLufs);
+			(*StatsObject)->TryGetNumberField(TEXT("silencePercent"), Asset.Stats.SilencePercent);
+		}
+
+		FString Status;
+		AssetObject->TryGetStringField(TEXT("status"), Status);
+		for (uint8 StatusIndex = 0; StatusIndex <= static_cast<uint8>(EAudioTrimmerAssetStatus::Failed); ++StatusIndex)
+		{
+			if (Status == LexToString(static_cast<EAudioTrimmerAssetStatus>(StatusIndex)))
+			{
+				Asset.Status = static_cast<EAudioTrimmerAssetStatus>(StatusIndex);
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Returns the name of the given status as it is written to the report
+const TCHAR* FAudioTrimmerReport::LexToString(EAudioTrimmerAssetStatus Status)
+{
+	switch (Status)
+	{
+	case EAudioTrimmerAssetStatus::Trimmed: return TEXT("Trimmed");
+	case EAudioTrimmerAssetStatus::Skipped: return TEXT("Skipped");
+	case EAudioTrimmerAssetStatus::Failed: return TEXT("Failed");
+	default: return TEXT("Pending");
+	}
+}
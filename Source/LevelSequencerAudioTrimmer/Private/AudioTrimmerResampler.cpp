@@ -0,0 +1,237 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerResampler.h"
+//---
+#include "AudioTrimmerUtilsLibrary.h"
+#include "AudioTrimmerWav.h"
+
+namespace AudioTrimmerResampler
+{
+	/** Kaiser window shape, about 80 dB of stop-band attenuation. */
+	constexpr double KaiserBeta = 8.0;
+
+	/** Fraction of the Nyquist frequency kept in the pass-band. */
+	constexpr double PassBand = 0.94;
+
+	/** Zeroth order modified Bessel function of the first kind. */
+	double BesselI0(double X)
+	{
+		double Sum = 1.0;
+		double Term = 1.0;
+		const double HalfXSquared = X * X / 4.0;
+		for (int32 K = 1; K < 32; ++K)
+		{
+			Term *= HalfXSquared / (K * K);
+			Sum += Term;
+			if (Term < Sum * 1e-12)
+			{
+				break;
+			}
+		}
+		return Sum;
+	}
+
+	/** Sum of products of two float arrays with the length multiple of 4. */
+	FORCEINLINE float DotProduct(const float* RESTRICT Samples, const float* RESTRICT Taps, int32 Num)
+	{
+		VectorRegister4Float Accumulator = VectorZeroFloat();
+		for (int32 Index = 0; Index < Num; Index += 4)
+		{
+			Accumulator = VectorMultiplyAdd(VectorLoad(Samples + Index), VectorLoad(Taps + Index), Accumulator);
+		}
+
+		alignas(16) float Lanes[4];
+		VectorStoreAligned(Accumulator, Lanes);
+		return Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3];
+	}
+}
+
+// Prepares the filter for converting between the given rates
+bool FAudioTrimmerResampler::Init(uint32 InSourceRate, uint32 InTargetRate, int32 InNumChannels)
+{
+	using namespace AudioTrimmerResampler;
+	static_assert(BaseTapsPerPhase % 8 == 0, "Taps have to be split evenly around the center and fill SIMD registers");
+
+	if (InSourceRate == 0 || InTargetRate == 0 || InNumChannels <= 0)
+	{
+		return false;
+	}
+
+	const uint32 Divisor = FMath::GreatestCommonDivisor(InSourceRate, InTargetRate);
+	UpFactor = InTargetRate / Divisor;
+	DownFactor = InSourceRate / Divisor;
+	NumChannels = InNumChannels;
+
+	if (UpFactor > MaxNumPhases)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Unsupported resampling ratio %u -> %u Hz, it needs %lld filter phases."), InSourceRate, InTargetRate, UpFactor);
+		return false;
+	}
+
+	// A lower cutoff needs a proportionally longer filter for the same transition band, otherwise decimation aliases
+	const double DecimationRatio = FMath::Max(1.0, static_cast<double>(DownFactor) / UpFactor);
+	TapsPerPhase = Align(FMath::CeilToInt32(BaseTapsPerPhase * DecimationRatio), 8);
+
+	// Prototype low-pass filter at the upsampled rate, its cutoff is below the lower of both Nyquist frequencies
+	const int64 PrototypeLength = TapsPerPhase * UpFactor;
+	const int64 Center = PrototypeLength / 2;
+	const double Cutoff = 0.5 * FMath::Min(1.0, static_cast<double>(UpFactor) / DownFactor) * PassBand;
+	const double WindowNormalizer = 1.0 / BesselI0(KaiserBeta);
+
+	PhaseTaps.SetNumUninitialized(PrototypeLength);
+	for (int64 Phase = 0; Phase < UpFactor; ++Phase)
+	{
+		float* Taps = &PhaseTaps[Phase * TapsPerPhase];
+		double PhaseSum = 0.0;
+
+		for (int32 TapIndex = 0; TapIndex < TapsPerPhase; ++TapIndex)
+		{
+			const int64 PrototypeIndex = Phase + TapIndex * UpFactor;
+			const double Offset = static_cast<double>(PrototypeIndex - Center) / UpFactor;
+			const double Sinc = FMath::IsNearlyZero(Offset) ? 1.0 : FMath::Sin(UE_DOUBLE_PI * 2.0 * Cutoff * Offset) / (UE_DOUBLE_PI * 2.0 * Cutoff * Offset);
+			const double WindowPosition = static_cast<double>(PrototypeIndex - Center) / Center;
+			const double Window = BesselI0(KaiserBeta * FMath::Sqrt(FMath::Max(0.0, 1.0 - WindowPosition * WindowPosition))) * WindowNormalizer;
+			const double Tap = 2.0 * Cutoff * Sinc * Window;
+
+			// Reversed, so the tap of the oldest input sample comes first
+			Taps[TapsPerPhase - 1 - TapIndex] = static_cast<float>(Tap);
+			PhaseSum += Tap;
+		}
+
+		// Keep unity gain for DC in every phase
+		if (!FMath::IsNearlyZero(PhaseSum))
+		{
+			for (int32 TapIndex = 0; TapIndex < TapsPerPhase; ++TapIndex)
+			{
+				Taps[TapIndex] = static_cast<float>(Taps[TapIndex] / PhaseSum);
+			}
+		}
+	}
+
+	// The first outputs look back at silence before the input
+	ChannelBuffers.SetNum(NumChannels);
+	for (TArray<float>& ChannelBuffer : ChannelBuffers)
+	{
+		ChannelBuffer.Reset();
+		ChannelBuffer.AddZeroed(TapsPerPhase);
+	}
+	BufferStartFrame = -TapsPerPhase;
+	NumInputFrames = 0;
+	NextOutputFrame = 0;
+
+	return true;
+}
+
+// Consumes interleaved input frames and appends all output frames that can already be produced
+void FAudioTrimmerResampler::Process(TConstArrayView<float> InterleavedInput, TArray<float>& OutInterleaved)
+{
+	const int32 NumFrames = InterleavedInput.Num() / NumChannels;
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		TArray<float>& ChannelBuffer = ChannelBuffers[Channel];
+		const int32 StartIndex = ChannelBuffer.AddUninitialized(NumFrames);
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			ChannelBuffer[StartIndex + Frame] = InterleavedInput[Frame * NumChannels + Channel];
+		}
+	}
+	NumInputFrames += NumFrames;
+
+	ProduceFrames(OutInterleaved, MAX_int64);
+}
+
+// Produces the remaining output frames, treating the input after its end as silence
+void FAudioTrimmerResampler::Flush(TArray<float>& OutInterleaved)
+{
+	for (TArray<float>& ChannelBuffer : ChannelBuffers)
+	{
+		ChannelBuffer.AddZeroed(TapsPerPhase + 1);
+	}
+
+	ProduceFrames(OutInterleaved, GetNumOutputFrames(NumInputFrames));
+}
+
+// Returns the number of output frames produced for the given number of input frames
+int64 FAudioTrimmerResampler::GetNumOutputFrames(int64 InNumInputFrames) const
+{
+	return (InNumInputFrames * UpFactor + DownFactor - 1) / DownFactor;
+}
+
+// Produces output frames while there is enough input history, or until the expected output length when flushing
+void FAudioTrimmerResampler::ProduceFrames(TArray<float>& OutInterleaved, int64 MaxOutputFrames)
+{
+	const int64 Center = TapsPerPhase * UpFactor / 2;
+	const int64 BufferEndFrame = BufferStartFrame + ChannelBuffers[0].Num();
+
+	while (NextOutputFrame < MaxOutputFrames)
+	{
+		// Newest input sample contributing to this output, and the filter phase for its fractional position
+		const int64 UpsampledPosition = NextOutputFrame * DownFactor + Center;
+		const int64 NewestFrame = UpsampledPosition / UpFactor;
+		if (NewestFrame >= BufferEndFrame)
+		{
+			break;
+		}
+
+		const int64 OldestIndex = NewestFrame - TapsPerPhase + 1 - BufferStartFrame;
+		const float* Taps = &PhaseTaps[(UpsampledPosition % UpFactor) * TapsPerPhase];
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			OutInterleaved.Add(AudioTrimmerResampler::DotProduct(&ChannelBuffers[Channel][OldestIndex], Taps, TapsPerPhase));
+		}
+
+		++NextOutputFrame;
+	}
+
+	// Drop the history that no future output needs
+	const int64 NextOldestFrame = (NextOutputFrame * DownFactor + Center) / UpFactor - TapsPerPhase + 1;
+	const int32 NumToDiscard = static_cast<int32>(FMath::Clamp<int64>(NextOldestFrame - BufferStartFrame, 0, ChannelBuffers[0].Num()));
+	if (NumToDiscard > 0)
+	{
+		for (TArray<float>& ChannelBuffer : ChannelBuffers)
+		{
+			ChannelBuffer.RemoveAt(0, NumToDiscard, EAllowShrinking::No);
+		}
+		BufferStartFrame += NumToDiscard;
+	}
+}
+
+// Resamples the given WAV file into a new WAV file of the same sample format
+bool FAudioTrimmerResampler::ResampleFile(const FString& InputPath, const FString& OutputPath, uint32 TargetSampleRate)
+{
+	FAudioTrimmerWavHeader InputHeader;
+	if (!FAudioTrimmerWav::ReadHeader(InputPath, InputHeader)
+		|| !InputHeader.IsUncompressed())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to read uncompressed WAV file for resampling: %s"), *InputPath);
+		return false;
+	}
+
+	FAudioTrimmerResampler Resampler;
+	if (!Resampler.Init(InputHeader.SampleRate, TargetSampleRate, InputHeader.NumChannels))
+	{
+		return false;
+	}
+
+	const FAudioTrimmerWavHeader OutputHeader = FAudioTrimmerWavHeader::Make(InputHeader.NumChannels, TargetSampleRate, InputHeader.GetBytesPerSample() * 8, InputHeader.IsFloat());
+	FAudioTrimmerWavWriter Writer;
+	if (!Writer.Open(OutputPath, OutputHeader, Resampler.GetNumOutputFrames(InputHeader.GetNumFrames())))
+	{
+		return false;
+	}
+
+	TArray<float> OutputSamples;
+	const bool bRead = FAudioTrimmerWav::ForEachSampleChunk(InputPath, InputHeader, [&](TConstArrayView<float> InterleavedSamples)
+	{
+		OutputSamples.Reset();
+		Resampler.Process(InterleavedSamples, OutputSamples);
+		return Writer.Write(OutputSamples);
+	});
+
+	OutputSamples.Reset();
+	Resampler.Flush(OutputSamples);
+
+	return bRead
+		&& Writer.Write(OutputSamples)
+		&& Writer.Close();
+}
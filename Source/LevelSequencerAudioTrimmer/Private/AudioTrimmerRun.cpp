@@ -0,0 +1,197 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerRun.h"
+//---
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "Sound/SoundWave.h"
+#include "Tasks/Task.h"
+#include "UObject/UObjectGlobals.h"
+
+// Starts the run, nothing is processed before the first step
+FAudioTrimmerRun::FAudioTrimmerRun(const FString& InRunName, const TArray<FAudioTrimmerAssetPlan>& InAssetPlans, const FAudioTrimmerRunCallbacks& InCallbacks)
+	: RunName(InRunName)
+	, AssetPlans(InAssetPlans)
+	, Callbacks(InCallbacks)
+	, Journal(InRunName)
+	, Report(InRunName)
+	, StartTime(FPlatformTime::Seconds())
+{
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Found %d sound waves to trim."), AssetPlans.Num());
+}
+
+// Starts the next batch of plans if none is in flight, and commits the batch in flight once its files are processed
+bool FAudioTrimmerRun::Step(bool bWaitForBatch)
+{
+	if (bFinished)
+	{
+		return false;
+	}
+
+	if (!IsBatchInFlight())
+	{
+		StartBatch();
+	}
+
+	if (bWaitForBatch)
+	{
+		// Meanwhile the game thread keeps loading prefetched packages, so the next sequences and sound waves are ready when they are needed
+		constexpr double AsyncLoadingTimeSliceSeconds = 0.005;
+		while (!UE::Tasks::Wait(FileTasks, FTimespan::FromSeconds(AsyncLoadingTimeSliceSeconds)))
+		{
+			if (IsAsyncLoading())
+			{
+				ProcessAsyncLoading(/*bUseTimeLimit*/true, /*bUseFullTimeLimit*/false, AsyncLoadingTimeSliceSeconds);
+			}
+		}
+	}
+	else if (FileTasks.ContainsByPredicate([](const UE::Tasks::FTask& FileTask) { return !FileTask.IsCompleted(); }))
+	{
+		// The editor keeps ticking, the batch is checked again on the next step
+		return true;
+	}
+
+	return CommitBatch();
+}
+
+// Exports the next batch of plans and launches the processing of their files on worker threads
+void FAudioTrimmerRun::StartBatch()
+{
+	// Plans are sorted by savings, so a time-boxed run still captures the biggest part of the reduction
+	const double MaxRunSeconds = UAudioTrimmerSettings::Get().MaxRunDurationMinutes * 60.0;
+
+	// Batches keep the number of temporary files on disk bounded by the number of worker threads
+	const int32 BatchSize = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+
+	// Export on the game thread, the exporter works with UObjects
+	BatchJobs.Reset();
+	while (PlanIndex < AssetPlans.Num() && BatchJobs.Num() < BatchSize)
+	{
+		if (MaxRunSeconds > 0.0
+			&& FPlatformTime::Seconds() - StartTime > MaxRunSeconds)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Run time limit of %.1f minutes is reached, remaining sounds are left for the next run."), MaxRunSeconds / 60.0);
+			break;
+		}
+
+		const FAudioTrimmerAssetPlan& AssetPlan = AssetPlans[PlanIndex++];
+
+		// Assets started by an interrupted run are always finished, even if they would be skipped now
+		if (!AssetPlan.SkipReason.IsEmpty()
+			&& Journal.GetState(AssetPlan.SoundWave->GetPathName()) == EAudioTrimmerJournalState::None)
+		{
+			UE_LOG(LogAudioTrimmer, Log, TEXT("Skipping %s: %s"), *AssetPlan.SoundWave->GetName(), *AssetPlan.SkipReason);
+			AddAsset(UAudioTrimmerUtilsLibrary::MakeAssetReport(AssetPlan, EAudioTrimmerAssetStatus::Skipped, AssetPlan.SkipReason));
+			continue;
+		}
+
+		FAudioTrimmerAssetJob& Job = BatchJobs.AddDefaulted_GetRef();
+		Job.AssetPlan = &AssetPlan;
+		UAudioTrimmerUtilsLibrary::ExportAssetPlan(Job, Journal);
+	}
+
+	bTimeLimitReached = PlanIndex < AssetPlans.Num() && BatchJobs.Num() < BatchSize;
+
+	// Trim, verify and convert the exported files in parallel, only files are touched there
+	FileTasks.Reserve(BatchJobs.Num());
+	for (FAudioTrimmerAssetJob& Job : BatchJobs)
+	{
+		FileTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, &Job]()
+		{
+			UAudioTrimmerUtilsLibrary::ProcessAssetFiles(Job, Journal);
+		}));
+	}
+}
+
+// Commits the processed batch, then finishes the run if it is complete, stopped or out of time
+bool FAudioTrimmerRun::CommitBatch()
+{
+	CommitBatchJobs();
+
+	if (bTimeLimitReached)
+	{
+		Finish(TEXT("run time limit is reached"));
+		return false;
+	}
+
+	// Stop only between batches, so every sound wave in flight is committed and nothing is left half trimmed
+	if (Callbacks.OnProgress
+		&& !Callbacks.OnProgress(GetProgress())
+		&& PlanIndex < AssetPlans.Num())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Run %s is cancelled, remaining sounds are left for the next run."), *RunName);
+		Finish(TEXT("run is cancelled"));
+		return false;
+	}
+
+	if (PlanIndex == AssetPlans.Num())
+	{
+		Finish(FString());
+		return false;
+	}
+
+	return true;
+}
+
+// Commits every job of the processed batch and reports them
+void FAudioTrimmerRun::CommitBatchJobs()
+{
+	FileTasks.Reset();
+
+	for (FAudioTrimmerAssetJob& Job : BatchJobs)
+	{
+		UAudioTrimmerUtilsLibrary::CommitAssetPlan(Job, Journal);
+		AddAsset(Job.Report);
+	}
+	BatchJobs.Reset();
+}
+
+// Stops the run, reports remaining plans as skipped and saves the report, does nothing if the run is already finished
+void FAudioTrimmerRun::Finish(const FString& StopReason)
+{
+	if (bFinished)
+	{
+		return;
+	}
+	bFinished = true;
+
+	// Sound waves in flight are always committed, so nothing is left half trimmed
+	if (IsBatchInFlight())
+	{
+		UE::Tasks::Wait(FileTasks);
+		CommitBatchJobs();
+	}
+
+	for (int32 Index = PlanIndex; Index < AssetPlans.Num(); ++Index)
+	{
+		AddAsset(UAudioTrimmerUtilsLibrary::MakeAssetReport(AssetPlans[Index], EAudioTrimmerAssetStatus::Skipped, StopReason));
+	}
+
+	// Failed or unfinished assets keep their records, so the next run rolls them back or finishes them
+	if (StopReason.IsEmpty()
+		&& Journal.IsEveryAssetCommitted())
+	{
+		Journal.Complete();
+	}
+	else
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Not every sound of %s was committed, its journal is kept for the next run: %s"), *RunName, *Journal.GetFilePath());
+	}
+
+	Report.Finish();
+	Report.Save();
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Processing complete."));
+}
+
+// Adds the outcome of one sound wave to the report and notifies the callback
+void FAudioTrimmerRun::AddAsset(const FAudioTrimmerAssetReport& AssetReport)
+{
+	Report.AddAsset(AssetReport);
+
+	if (Callbacks.OnAssetCompleted)
+	{
+		Callbacks.OnAssetCompleted(AssetReport);
+	}
+}
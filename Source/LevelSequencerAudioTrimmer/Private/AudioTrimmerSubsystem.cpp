@@ -0,0 +1,381 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerSubsystem.h"
+//---
+#include "AudioTrimmerRun.h"
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "Editor.h"
+#include "LevelSequence.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Sections/MovieSceneAudioSection.h"
+#include "UObject/GCObjectScopeGuard.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AudioTrimmerSubsystem)
+
+// Finishes the job, fulfilling its future and broadcasting the delegate
+void UAudioTrimmerJob::Complete(EAudioTrimmerJobState FinalState)
+{
+	State = FinalState;
+	Planner.Reset();
+	ReferencedObjects.Empty();
+	if (PrefetchHandle)
+	{
+		PrefetchHandle->ReleaseHandle();
+		PrefetchHandle.Reset();
+	}
+
+	Promise.SetValue(FinalState);
+	OnCompleted.Broadcast(this);
+}
+
+// Returns the subsystem of the editor, or null if there is no editor, e.g. in a game
+UAudioTrimmerSubsystem* UAudioTrimmerSubsystem::Get()
+{
+	return GEditor ? GEditor->GetEditorSubsystem<UAudioTrimmerSubsystem>() : nullptr;
+}
+
+// Queues trimming of all audio used by the given level sequence
+UAudioTrimmerJob* UAudioTrimmerSubsystem::EnqueueLevelSequence(const ULevelSequence* LevelSequence)
+{
+	TWeakObjectPtr<const ULevelSequence> WeakLevelSequence = LevelSequence;
+	return EnqueueJob(GetPathNameSafe(LevelSequence), [WeakLevelSequence]()
+	{
+		return UAudioTrimmerUtilsLibrary::PlanLevelSequenceAudioTrimming(WeakLevelSequence.Get());
+	}, {const_cast<ULevelSequence*>(LevelSequence)});
+}
+
+// Queues trimming of all audio used by the level sequence at the given path
+UAudioTrimmerJob* UAudioTrimmerSubsystem::EnqueueLevelSequencePath(const FSoftObjectPath& LevelSequencePath)
+{
+	return EnqueueJob(LevelSequencePath.ToString(), [LevelSequencePath]()
+	{
+		// Already loaded by the prefetch in most cases, otherwise loaded right now
+		const ULevelSequence* LevelSequence = Cast<ULevelSequence>(LevelSequencePath.TryLoad());
+		if (!LevelSequence)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to load level sequence: %s"), *LevelSequencePath.ToString());
+			return TArray<FAudioTrimmerAssetPlan>();
+		}
+
+		return UAudioTrimmerUtilsLibrary::PlanLevelSequenceAudioTrimming(LevelSequence);
+	}, {}, {LevelSequencePath});
+}
+
+// Queues trimming of the sound waves played by the given audio sections
+UAudioTrimmerJob* UAudioTrimmerSubsystem::EnqueueAudioSections(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections)
+{
+	TArray<UObject*> ReferencedObjects(AudioSections);
+	ReferencedObjects.Add(const_cast<ULevelSequence*>(LevelSequence));
+
+	// Separate journal, so finishing the selection never discards an interrupted run of the whole sequence
+	TWeakObjectPtr<const ULevelSequence> WeakLevelSequence = LevelSequence;
+	TArray<TWeakObjectPtr<UMovieSceneAudioSection>> WeakAudioSections(AudioSections);
+	return EnqueueJob(GetPathNameSafe(LevelSequence) + TEXT(".Selection"), [WeakLevelSequence, WeakAudioSections]()
+	{
+		TArray<UMovieSceneAudioSection*> SelectedSections;
+		for (const TWeakObjectPtr<UMovieSceneAudioSection>& WeakAudioSection : WeakAudioSections)
+		{
+			if (UMovieSceneAudioSection* AudioSection = WeakAudioSection.Get())
+			{
+				SelectedSections.Add(AudioSection);
+			}
+		}
+
+		return UAudioTrimmerUtilsLibrary::PlanAudioSectionsTrimming(WeakLevelSequence.Get(), SelectedSections);
+	}, ReferencedObjects);
+}
+
+// Queues a run that processes the plans created by the given planner once the job starts
+UAudioTrimmerJob* UAudioTrimmerSubsystem::EnqueueJob(const FString& RunName, TFunction<TArray<FAudioTrimmerAssetPlan>()> Planner, const TArray<UObject*>& ReferencedObjects, const TArray<FSoftObjectPath>& AssetsToPrefetch)
+{
+	UAudioTrimmerJob* Job = NewObject<UAudioTrimmerJob>(this);
+	Job->RunName = RunName;
+	Job->Planner = MoveTemp(Planner);
+	Job->ReferencedObjects.Append(ReferencedObjects);
+	Job->AssetsToPrefetch = AssetsToPrefetch;
+	QueuedJobs.Add(Job);
+	PrefetchQueuedJobs();
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Queued trimming job %s, %d jobs are waiting."), *RunName, QueuedJobs.Num());
+	return Job;
+}
+
+// Finishes the running job and runs all queued jobs right away
+void UAudioTrimmerSubsystem::RunQueuedJobs()
+{
+	if (bIsStepping)
+	{
+		return;
+	}
+
+	while (RunningJob || StartNextJob())
+	{
+		FinishRunningJob();
+	}
+}
+
+// Steps the running job until it is finished, showing a progress dialog that lets people cancel it
+void UAudioTrimmerSubsystem::FinishRunningJob()
+{
+	UAudioTrimmerJob* Job = RunningJob;
+	if (!Job)
+	{
+		return;
+	}
+
+	// The dialog lets people cancel the run, while commandlets log progress instead
+	TGCObjectScopeGuard<UAudioTrimmerJob> JobGuard(Job);
+	FScopedSlowTask SlowTask(1.f, FText::Format(NSLOCTEXT("LevelSequencerAudioTrimmer", "TrimmingJob", "Trimming audio of {0}"), FText::FromString(Job->RunName)));
+	if (!IsRunningCommandlet())
+	{
+		SlowTask.MakeDialog(/*bShowCancelButton*/true);
+	}
+
+	while (RunningJob == Job)
+	{
+		const float PreviousProgress = Job->Progress;
+		StepRunningJob(/*bWaitForBatch*/true);
+		SlowTask.EnterProgressFrame(Job->Progress - PreviousProgress);
+
+		if (SlowTask.ShouldCancel())
+		{
+			Job->Cancel();
+		}
+	}
+}
+
+// Finishes the running job, then runs the given queued job right away, other queued jobs keep waiting
+void UAudioTrimmerSubsystem::RunJob(UAudioTrimmerJob* Job)
+{
+	if (bIsStepping
+		|| !Job)
+	{
+		return;
+	}
+
+	if (RunningJob != Job)
+	{
+		// Jobs never race each other, so the one being run is finished first
+		FinishRunningJob();
+
+		// Jobs that are already finished or were never queued here have nothing to run
+		if (RunningJob
+			|| QueuedJobs.Remove(Job) == 0
+			|| !StartJob(Job))
+		{
+			return;
+		}
+	}
+
+	FinishRunningJob();
+}
+
+// Cancels the running job and all queued jobs
+void UAudioTrimmerSubsystem::CancelAllJobs()
+{
+	if (RunningJob)
+	{
+		RunningJob->Cancel();
+	}
+
+	const TArray<TObjectPtr<UAudioTrimmerJob>> JobsToCancel = MoveTemp(QueuedJobs);
+	QueuedJobs.Reset();
+	for (UAudioTrimmerJob* Job : JobsToCancel)
+	{
+		Job->Cancel();
+		Job->Complete(EAudioTrimmerJobState::Cancelled);
+	}
+}
+
+// Returns the running job followed by all queued jobs
+TArray<UAudioTrimmerJob*> UAudioTrimmerSubsystem::GetJobs() const
+{
+	TArray<UAudioTrimmerJob*> Jobs;
+	if (RunningJob)
+	{
+		Jobs.Add(RunningJob);
+	}
+	Jobs.Append(QueuedJobs);
+	return Jobs;
+}
+
+// Starts ticking the queue
+void UAudioTrimmerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+}
+
+// Cancels all jobs and stops ticking the queue
+void UAudioTrimmerSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	TickerHandle.Reset();
+
+	CancelAllJobs();
+
+	// The editor is closing, the running job cannot wait for its next batch
+	if (Run)
+	{
+		Run->Finish(TEXT("editor is closing"));
+		StepRunningJob(/*bWaitForBatch*/true);
+	}
+
+	Super::Deinitialize();
+}
+
+// Is called by the ticker to process the next batch of the running job, or to start the next queued job
+bool UAudioTrimmerSubsystem::Tick(float DeltaTime)
+{
+	// Never interrupt playing in editor or another slow task
+	if (bIsStepping
+		|| (GEditor && GEditor->PlayWorld)
+		|| GIsSlowTask)
+	{
+		return true;
+	}
+
+	// Files of a batch are processed on worker threads between ticks, so the tick never waits for them
+	if (RunningJob || StartNextJob())
+	{
+		StepRunningJob(/*bWaitForBatch*/false);
+	}
+
+	return true;
+}
+
+// Plans the next queued job and makes it the running one, jobs without anything to trim are completed at once
+bool UAudioTrimmerSubsystem::StartNextJob()
+{
+	while (!RunningJob && QueuedJobs.Num() > 0)
+	{
+		UAudioTrimmerJob* Job = QueuedJobs[0];
+		QueuedJobs.RemoveAt(0);
+		StartJob(Job);
+	}
+
+	return RunningJob != nullptr;
+}
+
+// Plans the given job that was taken out of the queue and makes it the running one, it is completed at once if there is nothing to trim
+bool UAudioTrimmerSubsystem::StartJob(UAudioTrimmerJob* Job)
+{
+	if (!Job
+		|| RunningJob)
+	{
+		return false;
+	}
+
+	// The queue has changed, so the next jobs are loaded ahead
+	PrefetchQueuedJobs();
+
+	if (Job->IsCancelRequested())
+	{
+		Job->Complete(EAudioTrimmerJobState::Cancelled);
+		return false;
+	}
+
+	const TArray<FAudioTrimmerAssetPlan> AssetPlans = Job->Planner ? Job->Planner() : TArray<FAudioTrimmerAssetPlan>();
+	if (AssetPlans.Num() == 0)
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Nothing to trim in %s."), *Job->RunName);
+		Job->Progress = 1.f;
+		Job->Complete(EAudioTrimmerJobState::Succeeded);
+		return false;
+	}
+
+	// Plans point to assets that have to stay loaded until the run is finished, even if the editor collects garbage between batches
+	for (const FAudioTrimmerAssetPlan& AssetPlan : AssetPlans)
+	{
+		Job->ReferencedObjects.Add(AssetPlan.SoundWave);
+		Job->ReferencedObjects.Append(AssetPlan.AudioSections);
+	}
+
+	FAudioTrimmerRunCallbacks Callbacks;
+	Callbacks.OnProgress = [Job](float Progress)
+	{
+		Job->Progress = Progress;
+		Job->OnProgress.Broadcast(Job, Progress);
+		return !Job->IsCancelRequested();
+	};
+	Callbacks.OnAssetCompleted = [Job](const FAudioTrimmerAssetReport& AssetReport)
+	{
+		Job->NumFailed += AssetReport.Status == EAudioTrimmerAssetStatus::Failed ? 1 : 0;
+		Job->OnAssetCompleted.Broadcast(Job, AssetReport.AssetPath, AssetReport.Status == EAudioTrimmerAssetStatus::Trimmed, AssetReport.Reason);
+	};
+
+	Job->State = EAudioTrimmerJobState::Running;
+	RunningJob = Job;
+	Run = MakeShared<FAudioTrimmerRun>(Job->RunName, AssetPlans, Callbacks);
+
+	return true;
+}
+
+// Processes the next batch of the running job, completes the job once its run is finished
+void UAudioTrimmerSubsystem::StepRunningJob(bool bWaitForBatch)
+{
+	if (!RunningJob
+		|| !Run)
+	{
+		return;
+	}
+
+	{
+		TGuardValue<bool> SteppingGuard(bIsStepping, true);
+		// A batch in flight is committed first, its progress callback then stops the run
+		if (RunningJob->IsCancelRequested()
+			&& !Run->IsBatchInFlight())
+		{
+			Run->Finish(TEXT("run is cancelled"));
+		}
+		else
+		{
+			Run->Step(bWaitForBatch);
+		}
+	}
+
+	if (Run->IsFinished())
+	{
+		UAudioTrimmerJob* Job = RunningJob;
+		const bool bCompleted = Run->IsCompleted();
+		RunningJob = nullptr;
+		Run.Reset();
+
+		TGCObjectScopeGuard<UAudioTrimmerJob> JobGuard(Job);
+		Job->Progress = bCompleted ? 1.f : Job->Progress;
+		Job->Complete(bCompleted ? EAudioTrimmerJobState::Succeeded : EAudioTrimmerJobState::Cancelled);
+
+		// Assets of the finished job are not referenced anymore, so memory is released before the next one is loaded
+		if (!IsEngineExitRequested())
+		{
+			UAudioTrimmerUtilsLibrary::CollectGarbageIfOverBudget();
+		}
+	}
+}
+
+// Starts loading assets of the next queued jobs in the background, up to the prefetch count from the settings
+void UAudioTrimmerSubsystem::PrefetchQueuedJobs()
+{
+	// Loading ahead would only push memory further over the budget
+	if (UAudioTrimmerUtilsLibrary::IsOverMemoryBudget())
+	{
+		return;
+	}
+
+	const int32 PrefetchCount = FMath::Min(UAudioTrimmerSettings::Get().PrefetchCount, QueuedJobs.Num());
+	for (int32 Index = 0; Index < PrefetchCount; ++Index)
+	{
+		UAudioTrimmerJob* Job = QueuedJobs[Index];
+		if (Job->PrefetchHandle
+			|| Job->AssetsToPrefetch.IsEmpty())
+		{
+			continue;
+		}
+
+		// Sound waves are hard references of level sequences, so they are loaded along with them
+		Job->PrefetchHandle = StreamableManager.RequestAsyncLoad(Job->AssetsToPrefetch, FStreamableDelegate(), FStreamableManager::DefaultAsyncLoadPriority);
+	}
+}
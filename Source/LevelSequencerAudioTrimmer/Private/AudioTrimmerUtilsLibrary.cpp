@@ -2,90 +2,906 @@
 
 #include "AudioTrimmerUtilsLibrary.h"
 //---
+#include "AudioTrimmerAnalyzer.h"
+#include "AudioTrimmerCache.h"
+#include "AudioTrimmerDsp.h"
+#include "AudioTrimmerJournal.h"
+#include "AudioTrimmerResampler.h"
+#include "AudioTrimmerRun.h"
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerSubsystem.h"
+#include "AudioTrimmerWav.h"
+#include "LevelSequencerAudioTrimmerEdModule.h"
+//---
 #include "AssetExportTask.h"
 #include "AssetToolsModule.h"
+#include "Editor.h"
+#include "FileHelpers.h"
 #include "LevelSequence.h"
-#include "LevelSequencerAudioTrimmerEdModule.h"
 #include "MovieScene.h"
+#include "MovieSceneTimeHelpers.h"
 #include "MovieSceneTrack.h"
 #include "ObjectTools.h"
+#include "Channels/MovieSceneFloatChannel.h"
 #include "Exporters/Exporter.h"
 #include "Factories/ReimportSoundFactory.h"
 #include "HAL/FileManager.h"
 #include "Misc/FileHelper.h"
+#include "Misc/ScopeExit.h"
 #include "Sections/MovieSceneAudioSection.h"
 #include "Sections/MovieSceneSubSection.h"
+#include "Sound/AudioSettings.h"
 #include "Sound/SampleBufferIO.h"
+#include "Sound/SoundBase.h"
 #include "Sound/SoundWave.h"
+#include "Tasks/Task.h"
 #include "Tests/AutomationEditorCommon.h"
 #include "Tracks/MovieSceneAudioTrack.h"
 #include "Tracks/MovieSceneSubTrack.h"
+#include "UObject/MetaData.h"
+#include <atomic>
 //---
 #include UE_INLINE_GENERATED_CPP_BY_NAME(AudioTrimmerUtilsLibrary)
 
+/** Names of the values recorded in the journal for each asset. */
+namespace AudioTrimmerJournalKeys
+{
+	const FString StartTimeMs = TEXT("StartTimeMs");
+	const FString EndTimeMs = TEXT("EndTimeMs");
+	const FString OriginalDurationMs = TEXT("OriginalDurationMs");
+	const FString ExportPath = TEXT("ExportPath");
+	const FString TrimmedPath = TEXT("TrimmedPath");
+	const FString TrimStartTimeSec = TEXT("TrimStartTimeSec");
+	const FString ResampledPath = TEXT("ResampledPath");
+	const FString MonoPath = TEXT("MonoPath");
+	const FString DownmixedToMono = TEXT("DownmixedToMono");
+	const FString SectionOffset = TEXT("Offset:");
+}
+
+/** Streaming of audio through the standard input and output of the ffmpeg executable. */
+namespace AudioTrimmerFfmpeg
+{
+	/** Returns the PCM codec keeping the bit depth of the given source, formats without one are decoded to 16-bit. */
+	const TCHAR* GetPcmCodec(TConstArrayView<uint8> InputBytes)
+	{
+		FAudioTrimmerWavHeader Header;
+		if (!FAudioTrimmerWav::ReadHeader(InputBytes, Header))
+		{
+			return TEXT("pcm_s16le");
+		}
+
+		if (Header.IsFloat()
+			|| Header.BitsPerSample > 24)
+		{
+			return TEXT("pcm_f32le");
+		}
+
+		return Header.BitsPerSample > 16 ? TEXT("pcm_s24le") : TEXT("pcm_s16le");
+	}
+
+	/** Streams the input through ffmpeg with the given filter arguments and reads back the WAV file it writes. */
+	bool RunWithPipes(TConstArrayView<uint8> InputBytes, TArray<uint8>& OutBytes, const FString& Filters)
+	{
+		OutBytes.Reset();
+
+		void* StdInRead = nullptr;
+		void* StdInWrite = nullptr;
+		void* StdOutRead = nullptr;
+		void* StdOutWrite = nullptr;
+		ON_SCOPE_EXIT
+		{
+			FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+			FPlatformProcess::ClosePipe(StdOutRead, StdOutWrite);
+		};
+
+		if (!FPlatformProcess::CreatePipe(StdInRead, StdInWrite, /*bWritePipeLocal*/true)
+			|| !FPlatformProcess::CreatePipe(StdOutRead, StdOutWrite))
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to create pipes for FFMPEG."));
+			return false;
+		}
+
+		// The output is PCM to be reimported as is
+		const FString& FfmpegPath = FLevelSequencerAudioTrimmerEdModule::GetFfmpegPath();
+		const FString CommandLineArgs = FString::Printf(TEXT("-hide_banner -loglevel error -i pipe:0 %s -c:a %s -f wav pipe:1"), *Filters, GetPcmCodec(InputBytes));
+
+		FProcHandle Process = FPlatformProcess::CreateProc(*FfmpegPath, *CommandLineArgs, /*bLaunchDetached*/false, /*bLaunchHidden*/true, /*bLaunchReallyHidden*/true, nullptr, 0, nullptr, StdOutWrite, StdInRead);
+		if (!Process.IsValid())
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to launch FFMPEG: %s"), *FfmpegPath);
+			return false;
+		}
+
+		// Only ffmpeg keeps its ends of the pipes, so they are closed by its exit and neither side waits for the other forever
+		FPlatformProcess::ClosePipe(StdInRead, nullptr);
+		FPlatformProcess::ClosePipe(nullptr, StdOutWrite);
+		StdInRead = nullptr;
+		StdOutWrite = nullptr;
+
+		// Input is written from another thread, otherwise both processes could block on full pipes waiting for each other.
+		// Only the reader polls the process, a full pipe and a closed one cannot be told apart here, so the writer waits for its flag
+		std::atomic<bool> bStopWriting = false;
+		UE::Tasks::FTask WriteTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [&InputBytes, &StdInWrite, &bStopWriting]()
+		{
+			constexpr int32 ChunkSize = 64 * 1024;
+			int32 Offset = 0;
+			while (Offset < InputBytes.Num()
+				&& !bStopWriting)
+			{
+				int32 WrittenBytes = 0;
+				FPlatformProcess::WritePipe(StdInWrite, InputBytes.GetData() + Offset, FMath::Min(ChunkSize, InputBytes.Num() - Offset), &WrittenBytes);
+				if (WrittenBytes > 0)
+				{
+					Offset += WrittenBytes;
+				}
+				else
+				{
+					FPlatformProcess::Sleep(0.001f);
+				}
+			}
+
+			// Closing the input tells ffmpeg that the whole file was sent
+			FPlatformProcess::ClosePipe(nullptr, StdInWrite);
+			StdInWrite = nullptr;
+		});
+
+		// Arrays are limited to 2 GiB, a longer output is cancelled instead
+		bool bOutputTooLarge = false;
+		TArray<uint8> OutputChunk;
+		auto ReadOutput = [&StdOutRead, &OutputChunk, &OutBytes, &bOutputTooLarge]()
+		{
+			if (!FPlatformProcess::ReadPipeToArray(StdOutRead, OutputChunk)
+				|| OutputChunk.Num() == 0)
+			{
+				return false;
+			}
+
+			if (OutputChunk.Num() > MAX_int32 - OutBytes.Num())
+			{
+				bOutputTooLarge = true;
+				return false;
+			}
+
+			OutBytes.Append(OutputChunk);
+			return true;
+		};
+
+		while (FPlatformProcess::IsProcRunning(Process)
+			&& !bOutputTooLarge)
+		{
+			if (!ReadOutput())
+			{
+				FPlatformProcess::Sleep(0.001f);
+			}
+		}
+
+		if (bOutputTooLarge)
+		{
+			FPlatformProcess::TerminateProc(Process);
+		}
+
+		// Whatever was written right before the exit is still in the pipe
+		while (ReadOutput())
+		{
+		}
+
+		bStopWriting = true;
+		WriteTask.Wait();
+
+		int32 ReturnCode = 0;
+		FPlatformProcess::GetProcReturnCode(Process, &ReturnCode);
+		FPlatformProcess::CloseProc(Process);
+
+		// Sizes cannot be written back to a pipe, so ffmpeg leaves placeholders in the header
+		if (bOutputTooLarge
+			|| ReturnCode != 0
+			|| !FAudioTrimmerWav::PatchStreamedSizes(OutBytes))
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("FFMPEG failed to process piped audio, return code: %d, output too large: %d"), ReturnCode, bOutputTooLarge);
+			OutBytes.Reset();
+			return false;
+		}
+
+		return true;
+	}
+}
+
 // Runs the audio trimmer for given level sequence
-void UAudioTrimmerUtilsLibrary::RunLevelSequenceAudioTrimmer(const ULevelSequence* LevelSequence)
+bool UAudioTrimmerUtilsLibrary::RunLevelSequenceAudioTrimmer(const ULevelSequence* LevelSequence)
 {
-	// Retrieve all audio sections from the Level Sequence
-	TArray<UMovieSceneAudioSection*> AudioSections = GetAudioSections(LevelSequence);
+	// Without the editor there is no scheduler to share, e.g. in a cook
+	UAudioTrimmerSubsystem* Subsystem = UAudioTrimmerSubsystem::Get();
+	if (!Subsystem)
+	{
+		int32 NumFailed = 0;
+		FAudioTrimmerRunCallbacks Callbacks;
+		Callbacks.OnAssetCompleted = [&NumFailed](const FAudioTrimmerAssetReport& AssetReport)
+		{
+			NumFailed += AssetReport.Status == EAudioTrimmerAssetStatus::Failed ? 1 : 0;
+		};
+
+		const bool bCompleted = RunAssetPlans(GetPathNameSafe(LevelSequence), PlanLevelSequenceAudioTrimming(LevelSequence), Callbacks);
+		return bCompleted && NumFailed == 0;
+	}
+
+	// Only this job is run, jobs queued by others keep waiting for their turn
+	UAudioTrimmerJob* Job = Subsystem->EnqueueLevelSequence(LevelSequence);
+	Subsystem->RunJob(Job);
+	return Job->GetState() == EAudioTrimmerJobState::Succeeded
+		&& Job->GetNumFailed() == 0;
+}
+
+// Runs the audio trimmer only for the sound waves of the given audio sections of the level sequence
+void UAudioTrimmerUtilsLibrary::RunAudioSectionsTrimmer(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections)
+{
+	UAudioTrimmerSubsystem* Subsystem = UAudioTrimmerSubsystem::Get();
+	if (!Subsystem)
+	{
+		RunAssetPlans(GetPathNameSafe(LevelSequence) + TEXT(".Selection"), PlanAudioSectionsTrimming(LevelSequence, AudioSections));
+		return;
+	}
+
+	// Only this job is run, jobs queued by others keep waiting for their turn
+	Subsystem->RunJob(Subsystem->EnqueueAudioSections(LevelSequence, AudioSections));
+}
+
+// Exports, trims and reimports the sound waves of all given plans, parallelizing the file stages
+bool UAudioTrimmerUtilsLibrary::RunAssetPlans(const FString& RunName, const TArray<FAudioTrimmerAssetPlan>& AssetPlans, const FAudioTrimmerRunCallbacks& Callbacks)
+{
+	if (AssetPlans.Num() == 0)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("No audio sections to trim in %s."), *RunName);
+		return true;
+	}
+
+	FAudioTrimmerRun Run(RunName, AssetPlans, Callbacks);
+	while (Run.Step())
+	{
+	}
+
+	return Run.IsCompleted();
+}
+
+// Returns true if the resident memory of this process exceeds the memory budget from the settings
+bool UAudioTrimmerUtilsLibrary::IsOverMemoryBudget()
+{
+	const int64 MemoryBudgetBytes = static_cast<int64>(UAudioTrimmerSettings::Get().GetMemoryBudgetMB()) * 1024 * 1024;
+	return MemoryBudgetBytes > 0
+		&& static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) > MemoryBudgetBytes;
+}
+
+// Collects garbage if the memory budget from the settings is exceeded
+bool UAudioTrimmerUtilsLibrary::CollectGarbageIfOverBudget()
+{
+	if (!IsOverMemoryBudget())
+	{
+		return false;
+	}
+
+	const uint64 UsedBytesBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+	// Undo history keeps every modified section alive, headless runs have nothing to undo anyway
+	if (IsRunningCommandlet()
+		&& GEditor)
+	{
+		GEditor->ResetTransaction(NSLOCTEXT("LevelSequencerAudioTrimmer", "ReleaseMemory", "Audio Trimmer memory budget"));
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, /*bPerformFullPurge*/true);
+
+	const uint64 UsedBytesAfter = FPlatformMemory::GetStats().UsedPhysical;
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Memory budget of %d MB exceeded, collected garbage: %llu MB -> %llu MB."),
+	       UAudioTrimmerSettings::Get().GetMemoryBudgetMB(), UsedBytesBefore / (1024 * 1024), UsedBytesAfter / (1024 * 1024));
+	return true;
+}
+
+// Groups all audio sections of the given level sequence by their sound waves and calculates the used range of each sound wave
+TArray<FAudioTrimmerAssetPlan> UAudioTrimmerUtilsLibrary::PlanLevelSequenceAudioTrimming(const ULevelSequence* LevelSequence)
+{
+	// Every section of the hierarchy is planned, including the ones that are never heard, so all of them are rebased
+	TArray<UMovieSceneAudioSection*> AudioSections;
+	GetSectionRanges(LevelSequence).GetKeys(AudioSections);
+
+	TArray<FAudioTrimmerAssetPlan> AssetPlans;
+	AddAudioSectionsToPlans(LevelSequence, AudioSections, AssetPlans);
+	FinalizeAssetPlans(AssetPlans);
+	return AssetPlans;
+}
+
+// Plans trimming of the sound waves played by the given audio sections, along with all other sections of the level sequence playing them
+TArray<FAudioTrimmerAssetPlan> UAudioTrimmerUtilsLibrary::PlanAudioSectionsTrimming(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections)
+{
+	TSet<const USoundBase*> SelectedSounds;
+	for (const UMovieSceneAudioSection* AudioSection : AudioSections)
+	{
+		if (AudioSection)
+		{
+			SelectedSounds.Add(AudioSection->GetSound());
+		}
+	}
+
+	// Other sections playing the same sounds are rebased too, so they keep playing the same audio
+	TArray<UMovieSceneAudioSection*> SectionsToPlan;
+	GetSectionRanges(LevelSequence).GetKeys(SectionsToPlan);
+	SectionsToPlan.RemoveAll([&SelectedSounds](const UMovieSceneAudioSection* AudioSection)
+	{
+		return !SelectedSounds.Contains(AudioSection->GetSound());
+	});
+
+	TArray<FAudioTrimmerAssetPlan> AssetPlans;
+	AddAudioSectionsToPlans(LevelSequence, SectionsToPlan, AssetPlans);
+	FinalizeAssetPlans(AssetPlans);
+	return AssetPlans;
+}
+
+// Adds the used ranges of given audio sections to the plans of their sound waves, creating missing plans
+void UAudioTrimmerUtilsLibrary::AddAudioSectionsToPlans(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections, TArray<FAudioTrimmerAssetPlan>& InOutAssetPlans)
+{
+	TMap<const USoundWave*, int32> PlanIndices;
+	TSet<const UMovieSceneAudioSection*> PlannedSections;
+	for (int32 Index = 0; Index < InOutAssetPlans.Num(); ++Index)
+	{
+		PlanIndices.Add(InOutAssetPlans[Index].SoundWave, Index);
+		for (const UMovieSceneAudioSection* AudioSection : InOutAssetPlans[Index].AudioSections)
+		{
+			PlannedSections.Add(AudioSection);
+		}
+	}
+
+	// Used ranges depend on the whole hierarchy of the sequence, so they are collected once
+	const TMap<UMovieSceneAudioSection*, TRange<FFrameNumber>> SectionRanges = GetSectionRanges(LevelSequence);
+
+	for (UMovieSceneAudioSection* AudioSection : AudioSections)
+	{
+		USoundWave* SoundWave = AudioSection ? Cast<USoundWave>(AudioSection->GetSound()) : nullptr;
+		if (!SoundWave)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to get SoundWave from AudioSection. Skipping..."));
+			continue;
+		}
+
+		const TRange<FFrameNumber>* SectionRange = SectionRanges.Find(AudioSection);
+		if (!SectionRange)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Section playing %s is not part of %s. Skipping..."), *SoundWave->GetName(), *GetNameSafe(LevelSequence));
+			continue;
+		}
+
+		int32 StartTimeMs = 0;
+		int32 EndTimeMs = 0;
+		CalculateSectionTrimTimes(AudioSection, *SectionRange, StartTimeMs, EndTimeMs);
+
+		int32& PlanIndex = PlanIndices.FindOrAdd(SoundWave, INDEX_NONE);
+		if (PlanIndex == INDEX_NONE)
+		{
+			PlanIndex = InOutAssetPlans.AddDefaulted();
+			InOutAssetPlans[PlanIndex].SoundWave = SoundWave;
+		}
+
+		FAudioTrimmerAssetPlan& AssetPlan = InOutAssetPlans[PlanIndex];
+		// Sections of a sub-sequence shared by several sequences must be rebased only once
+		bool bAlreadyPlanned = false;
+		PlannedSections.Add(AudioSection, &bAlreadyPlanned);
+		if (!bAlreadyPlanned)
+		{
+			AssetPlan.AudioSections.Add(AudioSection);
+		}
+		AssetPlan.AddUsedRange(StartTimeMs, EndTimeMs);
+	}
+}
+
+// Applies the trimming policy to complete plans and sorts them by estimated savings
+void UAudioTrimmerUtilsLibrary::FinalizeAssetPlans(TArray<FAudioTrimmerAssetPlan>& InOutAssetPlans)
+{
+	ApplyTrimmingPolicy(InOutAssetPlans);
+
+	// Biggest wins first
+	InOutAssetPlans.StableSort([](const FAudioTrimmerAssetPlan& A, const FAudioTrimmerAssetPlan& B)
+	{
+		return A.GetEstimatedSavedBytes() > B.GetEstimatedSavedBytes();
+	});
+}
+
+// Estimates the size of the source audio of the plan after trimming and the configured format conversions
+int64 UAudioTrimmerUtilsLibrary::EstimateTrimmedBytes(const FAudioTrimmerAssetPlan& AssetPlan)
+{
+	const USoundWave* SoundWave = AssetPlan.SoundWave;
+	if (!SoundWave)
+	{
+		return 0;
+	}
+
+	// Without the source payload, assume 16-bit PCM of the sound's format
+	const float SampleRate = SoundWave->GetSampleRateForCurrentPlatform();
+	int64 SourceBytes = AssetPlan.SourceSizeBytes;
+	if (SourceBytes <= 0)
+	{
+		constexpr int32 BytesPerSample = 2;
+		SourceBytes = static_cast<int64>(SoundWave->Duration * SampleRate) * FMath::Max(SoundWave->NumChannels, 1) * BytesPerSample;
+	}
+
+	double TrimmedBytes = SourceBytes * static_cast<double>(AssetPlan.GetUsedFraction());
+
+	const UAudioTrimmerSettings& Settings = UAudioTrimmerSettings::Get();
+	if (Settings.bResampleToTargetRate
+		&& SampleRate > Settings.TargetSampleRate)
+	{
+		TrimmedBytes *= Settings.TargetSampleRate / SampleRate;
+	}
+
+	return static_cast<int64>(TrimmedBytes);
+}
+
+// Extends used ranges by the configured padding and marks sound waves with too small savings as skipped
+void UAudioTrimmerUtilsLibrary::ApplyTrimmingPolicy(TArray<FAudioTrimmerAssetPlan>& InOutAssetPlans)
+{
+	const UAudioTrimmerSettings& Settings = UAudioTrimmerSettings::Get();
+
+	for (FAudioTrimmerAssetPlan& AssetPlan : InOutAssetPlans)
+	{
+		const USoundWave* SoundWave = AssetPlan.SoundWave;
+		AssetPlan.DurationMs = static_cast<int32>(SoundWave->Duration * 1000.0f);
+		AssetPlan.SourceSizeBytes = SoundWave->RawData.GetPayloadSize();
+
+		AssetPlan.StartTimeMs = FMath::Max(AssetPlan.StartTimeMs - Settings.HeadPaddingMs, 0);
+		AssetPlan.EndTimeMs = FMath::Min(AssetPlan.EndTimeMs + Settings.TailPaddingMs, AssetPlan.DurationMs);
+		AssetPlan.EstimatedTrimmedBytes = EstimateTrimmedBytes(AssetPlan);
+
+		const int64 SavedBytes = AssetPlan.GetEstimatedSavedBytes();
+		const float SavedPercent = (1.f - AssetPlan.GetUsedFraction()) * 100.f;
+		if (SavedBytes <= 0)
+		{
+			AssetPlan.SkipReason = TEXT("the whole sound is used");
+		}
+		else if (SavedBytes < Settings.MinSavedBytes)
+		{
+			AssetPlan.SkipReason = FString::Printf(TEXT("would save only %lld bytes, the minimum is %lld bytes"), SavedBytes, Settings.MinSavedBytes);
+		}
+		else if (SavedPercent < Settings.MinSavedPercent)
+		{
+			AssetPlan.SkipReason = FString::Printf(TEXT("would save only %.2f%%, the minimum is %.2f%%"), SavedPercent, Settings.MinSavedPercent);
+		}
+	}
+}
+
+// Exports, trims, reimports the sound wave of the given plan and rebases all its sections, recording each step in the journal
+bool UAudioTrimmerUtilsLibrary::ProcessAssetPlan(const FAudioTrimmerAssetPlan& AssetPlan, FAudioTrimmerJournal& Journal)
+{
+	FAudioTrimmerAssetJob Job;
+	Job.AssetPlan = &AssetPlan;
+
+	ExportAssetPlan(Job, Journal);
+	ProcessAssetFiles(Job, Journal);
+	return CommitAssetPlan(Job, Journal);
+}
+
+// Exports the sound wave of the job into a temporary WAV file, rolling back or skipping work left by an interrupted run
+void UAudioTrimmerUtilsLibrary::ExportAssetPlan(FAudioTrimmerAssetJob& InOutJob, FAudioTrimmerJournal& Journal)
+{
+	USoundWave* SoundWave = InOutJob.AssetPlan ? InOutJob.AssetPlan->SoundWave : nullptr;
+	if (!SoundWave)
+	{
+		InOutJob.bFailed = true;
+		return;
+	}
+
+	const FAudioTrimmerAssetPlan& AssetPlan = *InOutJob.AssetPlan;
+	InOutJob.Report = MakeAssetReport(AssetPlan, EAudioTrimmerAssetStatus::Pending);
+	InOutJob.SourceHash = LexToString(SoundWave->RawData.GetPayloadId());
+
+	const double StageStartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		InOutJob.Report.ExportSeconds = FPlatformTime::Seconds() - StageStartTime;
+	};
+
+	const FString AssetPath = SoundWave->GetPathName();
+	const EAudioTrimmerJournalState State = Journal.GetState(AssetPath);
+
+	if (State == EAudioTrimmerJournalState::Committed)
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("%s was already trimmed by the interrupted run. Skipping..."), *SoundWave->GetName());
+		InOutJob.bCommitted = true;
+		return;
+	}
+
+	if (State == EAudioTrimmerJournalState::Reimported)
+	{
+		InOutJob.bReimported = true;
+		return;
+	}
+
+	if (State != EAudioTrimmerJournalState::None)
+	{
+		// Roll back partial steps, temporary files are recreated from scratch
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::ExportPath));
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::TrimmedPath));
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::ResampledPath));
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::MonoPath));
+
+		// The crash might have happened right after the reimport was saved, but before it was journaled
+		const int32 OriginalDurationMs = FCString::Atoi(*Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::OriginalDurationMs));
+		const int32 CurrentDurationMs = static_cast<int32>(SoundWave->Duration * 1000.0f);
+		if (FMath::Abs(CurrentDurationMs - OriginalDurationMs) > 1)
+		{
+			// A reimport whose save failed must not be trimmed again, nor have its sections rebased before it is saved
+			if (SoundWave->GetPackage()->IsDirty())
+			{
+				UE_LOG(LogAudioTrimmer, Warning, TEXT("Trimmed %s is not saved yet, save or reload it first. Skipping..."), *SoundWave->GetName());
+				InOutJob.bFailed = true;
+				InOutJob.Report.Reason = TEXT("trimmed sound wave is not saved");
+				return;
+			}
+
+			InOutJob.bReimported = true;
+			return;
+		}
+	}
+
+	TMap<FString, FString> PlannedValues;
+	PlannedValues.Add(AudioTrimmerJournalKeys::StartTimeMs, LexToString(AssetPlan.StartTimeMs));
+	PlannedValues.Add(AudioTrimmerJournalKeys::EndTimeMs, LexToString(AssetPlan.EndTimeMs));
+	PlannedValues.Add(AudioTrimmerJournalKeys::OriginalDurationMs, LexToString(static_cast<int32>(SoundWave->Duration * 1000.0f)));
+	for (const UMovieSceneAudioSection* AudioSection : AssetPlan.AudioSections)
+	{
+		PlannedValues.Add(AudioTrimmerJournalKeys::SectionOffset + AudioSection->GetPathName(), LexToString(AudioSection->GetStartOffset().Value));
+	}
+	Journal.Append(AssetPath, EAudioTrimmerJournalState::Planned, PlannedValues);
+
+	// Compressed sources are piped to ffmpeg straight from the payload, uncompressed ones are still exported to be sliced in-process
+	const FSharedBuffer SourcePayload = UAudioTrimmerSettings::Get().bPipeFfmpegAudio ? SoundWave->RawData.GetPayload().Get() : FSharedBuffer();
+	if (!SourcePayload.IsNull()
+		&& SourcePayload.GetSize() <= MAX_int32)
+	{
+		// The sample rate of the header lets ffmpeg cut at exact samples, payloads without it are exported instead
+		const TConstArrayView<uint8> SourceBytes(static_cast<const uint8*>(SourcePayload.GetData()), static_cast<int32>(SourcePayload.GetSize()));
+		FAudioTrimmerWavHeader SourceHeader;
+		if (FAudioTrimmerWav::ReadHeader(SourceBytes, SourceHeader)
+			&& !SourceHeader.IsUncompressed()
+			&& SourceHeader.SampleRate > 0)
+		{
+			// Settings that work on samples need the decoded source in a file, its paths are recorded for cleanup
+			TMap<FString, FString> ExportedValues;
+			if (IsDecodedSourceRequired())
+			{
+				InOutJob.ExportPath = GetExportPath(SoundWave);
+				ExportedValues.Add(AudioTrimmerJournalKeys::ExportPath, InOutJob.ExportPath);
+				ExportedValues.Add(AudioTrimmerJournalKeys::TrimmedPath, FPaths::ChangeExtension(InOutJob.ExportPath, TEXT("_trimmed.wav")));
+			}
+
+			Journal.Append(AssetPath, EAudioTrimmerJournalState::Exported, ExportedValues);
+			InOutJob.SourcePayload = SourcePayload;
+			return;
+		}
+	}
+
+	// Export the sound wave to a temporary WAV file
+	const FString ExportPath = ExportSoundWaveToWav(SoundWave);
+	if (ExportPath.IsEmpty())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to export %s. Skipping..."), *SoundWave->GetName());
+		InOutJob.bFailed = true;
+		InOutJob.Report.Reason = TEXT("export failed");
+		return;
+	}
+
+	// The trimmed path is recorded upfront, so it is cleaned up even if the worker thread is interrupted
+	TMap<FString, FString> ExportedValues;
+	ExportedValues.Add(AudioTrimmerJournalKeys::ExportPath, ExportPath);
+	ExportedValues.Add(AudioTrimmerJournalKeys::TrimmedPath, FPaths::ChangeExtension(ExportPath, TEXT("_trimmed.wav")));
+	Journal.Append(AssetPath, EAudioTrimmerJournalState::Exported, ExportedValues);
+
+	InOutJob.ExportPath = ExportPath;
+}
+
+// Trims, verifies and converts the exported audio of the job, touches only files, so it can run on any thread
+void UAudioTrimmerUtilsLibrary::ProcessAssetFiles(FAudioTrimmerAssetJob& InOutJob, FAudioTrimmerJournal& Journal)
+{
+	if (InOutJob.bFailed
+		|| (InOutJob.ExportPath.IsEmpty() && InOutJob.SourcePayload.IsNull()))
+	{
+		return;
+	}
+
+	const double StageStartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		InOutJob.Report.ProcessSeconds = FPlatformTime::Seconds() - StageStartTime;
+	};
+
+	const FAudioTrimmerAssetPlan& AssetPlan = *InOutJob.AssetPlan;
+	const FString SoundName = AssetPlan.SoundWave->GetName();
+	const FString AssetPath = AssetPlan.SoundWave->GetPathName();
+	const FString& ExportPath = InOutJob.ExportPath;
+	const UAudioTrimmerSettings& Settings = UAudioTrimmerSettings::Get();
+
+	const float StartTimeSec = AssetPlan.StartTimeMs / 1000.0f;
+	const float EndTimeSec = AssetPlan.EndTimeMs / 1000.0f;
+
+	// Piped sources never touch the disk, they are reimported from memory as they come out of ffmpeg
+	if (!InOutJob.SourcePayload.IsNull())
+	{
+		// Views over the payload are limited to 2 GiB
+		if (InOutJob.SourcePayload.GetSize() > MAX_int32)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Source of %s is too large to be piped. Skipping..."), *SoundName);
+			InOutJob.bFailed = true;
+			InOutJob.Report.Reason = TEXT("source too large to pipe");
+			return;
+		}
+
+		const TConstArrayView<uint8> SourceBytes(static_cast<const uint8*>(InOutJob.SourcePayload.GetData()), static_cast<int32>(InOutJob.SourcePayload.GetSize()));
+		FAudioTrimmerWavHeader SourceHeader;
+		if (!FAudioTrimmerWav::ReadHeader(SourceBytes, SourceHeader)
+			|| SourceHeader.SampleRate == 0)
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to read the sample rate of %s. Skipping..."), *SoundName);
+			InOutJob.bFailed = true;
+			InOutJob.Report.Reason = TEXT("unknown sample rate");
+			return;
+		}
+
+		// The export stage planned a file for the decoded source, so it is trimmed below like any uncompressed export
+		if (!ExportPath.IsEmpty())
+		{
+			TArray<uint8> DecodedBytes;
+			if (!DecodeAudioWithFfmpegPipes(SourceBytes, DecodedBytes)
+				|| !FFileHelper::SaveArrayToFile(DecodedBytes, *ExportPath))
+			{
+				UE_LOG(LogAudioTrimmer, Warning, TEXT("Decoding audio failed for %s. Skipping..."), *SoundName);
+				InOutJob.bFailed = true;
+				InOutJob.Report.Reason = TEXT("decoding failed");
+				return;
+			}
+
+			InOutJob.SourcePayload.Reset();
+			InOutJob.Report.Notes.Add(TEXT("decoded through ffmpeg"));
+		}
+		else
+		{
+			// Cut at exact samples, so the journaled start matches the audio ffmpeg keeps
+			const FAudioTrimmerFrameRange FrameRange(FMath::RoundToInt64(StartTimeSec * SourceHeader.SampleRate), FMath::RoundToInt64(EndTimeSec * SourceHeader.SampleRate));
+			if (!TrimAudioWithFfmpegPipes(SourceBytes, InOutJob.ReimportBytes, FrameRange))
+			{
+				UE_LOG(LogAudioTrimmer, Warning, TEXT("Trimming audio failed for %s. Skipping..."), *SoundName);
+				InOutJob.bFailed = true;
+				InOutJob.Report.Reason = TEXT("trimming failed");
+				return;
+			}
+
+			// Decoded PCM is already in memory, so measuring it does not read anything again
+			if (Settings.bAnalyzeTrimmedAudio)
+			{
+				FAudioTrimmerAnalyzer::AnalyzeWav(InOutJob.ReimportBytes, Settings.SilenceThresholdDb, InOutJob.Report.Stats);
+			}
+
+			const double TrimStartTimeSec = static_cast<double>(FrameRange.StartFrame) / SourceHeader.SampleRate;
+			Journal.Append(AssetPath, EAudioTrimmerJournalState::Trimmed, {{AudioTrimmerJournalKeys::TrimStartTimeSec, LexToSanitizedString(TrimStartTimeSec)}});
+			InOutJob.SourcePayload.Reset();
+			InOutJob.Report.Notes.Add(TEXT("piped through ffmpeg"));
+			return;
+		}
+	}
+
+	const FString TrimmedAudioPath = FPaths::ChangeExtension(ExportPath, TEXT("_trimmed.wav"));
+
+	// Trim uncompressed audio by frames, so the exact start is known even if the cut was snapped to a zero crossing
+	bool bTrimmed = false;
+	double TrimStartTimeSec = StartTimeSec;
+	FAudioTrimmerWavHeader ExportHeader;
+	if (FAudioTrimmerWav::ReadHeader(ExportPath, ExportHeader)
+		&& ExportHeader.IsUncompressed())
+	{
+		FAudioTrimmerFrameRange FrameRange(FMath::RoundToInt64(StartTimeSec * ExportHeader.SampleRate), FMath::RoundToInt64(EndTimeSec * ExportHeader.SampleRate));
+		bTrimmed = TrimAudioFrames(ExportPath, TrimmedAudioPath, FrameRange, InOutJob.SourceHash, &InOutJob.Report.Stats);
+		TrimStartTimeSec = static_cast<double>(FrameRange.StartFrame) / ExportHeader.SampleRate;
+
+		// Faded edges are expected to differ from the source
+		if (bTrimmed
+			&& Settings.bVerifyTrimmedAudio)
+		{
+			const int64 FadeFrames = Settings.bApplyEdgeFades ? FMath::RoundToInt64(Settings.EdgeFadeMs / 1000.0 * ExportHeader.SampleRate) : 0;
+			const int64 IgnoredHeadFrames = FrameRange.StartFrame > 0 ? FadeFrames : 0;
+			const int64 IgnoredTailFrames = FrameRange.EndFrame < ExportHeader.GetNumFrames() ? FadeFrames : 0;
+			if (!FAudioTrimmerDsp::VerifyTrimmedFile(ExportPath, TrimmedAudioPath, FrameRange, IgnoredHeadFrames, IgnoredTailFrames))
+			{
+				UE_LOG(LogAudioTrimmer, Error, TEXT("Trimmed audio of %s does not match its source, reimport is cancelled."), *SoundName);
+				InOutJob.bFailed = true;
+				InOutJob.Report.Reason = TEXT("trimmed audio does not match its source");
+				return;
+			}
+		}
+	}
+	else
+	{
+		bTrimmed = TrimAudio(ExportPath, TrimmedAudioPath, StartTimeSec, EndTimeSec);
+	}
+
+	if (!bTrimmed)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Trimming audio failed for %s. Skipping..."), *SoundName);
+		InOutJob.bFailed = true;
+		InOutJob.Report.Reason = TEXT("trimming failed");
+		return;
+	}
+
+	Journal.Append(AssetPath, EAudioTrimmerJournalState::Trimmed, {{AudioTrimmerJournalKeys::TrimStartTimeSec, LexToSanitizedString(TrimStartTimeSec)}});
+
+	FString ReimportAudioPath = TrimmedAudioPath;
+
+	// Optionally write stereo audio with identical channels as mono
+	if (Settings.bDownmixFakeStereo
+		&& FAudioTrimmerDsp::IsFakeStereo(ReimportAudioPath, Settings.FakeStereoTolerance))
+	{
+		const FString MonoAudioPath = FPaths::ChangeExtension(ExportPath, TEXT("_mono.wav"));
+		Journal.Append(AssetPath, EAudioTrimmerJournalState::Trimmed, {{AudioTrimmerJournalKeys::MonoPath, MonoAudioPath}});
+
+		if (FAudioTrimmerDsp::DownmixFileToMono(ReimportAudioPath, MonoAudioPath))
+		{
+			ReimportAudioPath = MonoAudioPath;
+			Journal.Append(AssetPath, EAudioTrimmerJournalState::Trimmed, {{AudioTrimmerJournalKeys::DownmixedToMono, TEXT("true")}});
+			InOutJob.Report.Notes.Add(TEXT("fake stereo downmixed to mono"));
+			UE_LOG(LogAudioTrimmer, Log, TEXT("%s has identical stereo channels, downmixed to mono."), *SoundName);
+		}
+		else
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Downmixing to mono failed for %s, keeping it stereo."), *SoundName);
+		}
+	}
+
+	// Optionally downconvert the sample rate of the trimmed audio
+	FAudioTrimmerWavHeader TrimmedHeader;
+	if (Settings.bResampleToTargetRate
+		&& FAudioTrimmerWav::ReadHeader(ReimportAudioPath, TrimmedHeader)
+		&& TrimmedHeader.SampleRate > static_cast<uint32>(Settings.TargetSampleRate))
+	{
+		const FString ResampledAudioPath = FPaths::ChangeExtension(ExportPath, TEXT("_resampled.wav"));
+		Journal.Append(AssetPath, EAudioTrimmerJournalState::Trimmed, {{AudioTrimmerJournalKeys::ResampledPath, ResampledAudioPath}});
+
+		if (ResampleAudio(ReimportAudioPath, ResampledAudioPath, Settings.TargetSampleRate))
+		{
+			ReimportAudioPath = ResampledAudioPath;
+			InOutJob.Report.Notes.Add(FString::Printf(TEXT("resampled from %u Hz to %d Hz"), TrimmedHeader.SampleRate, Settings.TargetSampleRate));
+		}
+		else
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Resampling failed for %s, keeping its original sample rate."), *SoundName);
+		}
+	}
+
+	InOutJob.ReimportPath = ReimportAudioPath;
+}
+
+// Reimports the processed audio of the job and rebases all sections of its plan, recording each step in the journal
+bool UAudioTrimmerUtilsLibrary::CommitAssetPlan(FAudioTrimmerAssetJob& InOutJob, FAudioTrimmerJournal& Journal)
+{
+	USoundWave* SoundWave = InOutJob.AssetPlan ? InOutJob.AssetPlan->SoundWave : nullptr;
+	if (!SoundWave)
+	{
+		return false;
+	}
 
-	if (AudioSections.Num() == 0)
+	const double StageStartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
 	{
-		UE_LOG(LogAudioTrimmer, Warning, TEXT("No audio sections found in the level sequence."));
-		return;
+		InOutJob.Report.CommitSeconds = FPlatformTime::Seconds() - StageStartTime;
+		InOutJob.Report.NewBytes = SoundWave->RawData.GetPayloadSize();
+		InOutJob.Report.NewDurationSec = SoundWave->Duration;
+	};
+
+	if (InOutJob.bCommitted)
+	{
+		InOutJob.Report.Status = EAudioTrimmerAssetStatus::Trimmed;
+		InOutJob.Report.Notes.Add(TEXT("trimmed by an interrupted run"));
+		return true;
 	}
 
-	UE_LOG(LogAudioTrimmer, Log, TEXT("Found %d audio sections."), AudioSections.Num());
+	const FAudioTrimmerAssetPlan& AssetPlan = *InOutJob.AssetPlan;
+	const FString AssetPath = SoundWave->GetPathName();
 
-	for (UMovieSceneAudioSection* AudioSection : AudioSections)
+	auto DeleteTempFiles = [&Journal, &AssetPath]()
 	{
-		USoundWave* SoundWave = Cast<USoundWave>(AudioSection->GetSound());
-		if (!SoundWave)
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::ExportPath));
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::TrimmedPath));
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::ResampledPath));
+		DeleteTempWavFile(Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::MonoPath));
+	};
+
+	if (InOutJob.bFailed)
+	{
+		// The source asset is untouched, the next run starts this sound wave over
+		DeleteTempFiles();
+		InOutJob.Report.Status = EAudioTrimmerAssetStatus::Failed;
+		return false;
+	}
+
+	if (InOutJob.bReimported)
+	{
+		// Sound wave is already trimmed on disk, only sections are left to rebase
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Finishing interrupted trim of %s."), *SoundWave->GetName());
+	}
+	else
+	{
+		// Reimport the trimmed audio into the original sound wave asset, piped audio is already in memory
+		const bool bReimportSucceeded = InOutJob.ReimportBytes.Num() > 0
+			? ReimportAudioFromMemory(SoundWave, InOutJob.ReimportBytes)
+			: ReimportAudioToUnreal(SoundWave, InOutJob.ReimportPath);
+		InOutJob.ReimportBytes.Empty();
+		if (!bReimportSucceeded)
 		{
-			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to get SoundWave from AudioSection. Skipping..."));
-			continue;
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Reimporting trimmed audio failed for %s. Skipping..."), *SoundWave->GetName());
+			InOutJob.Report.Status = EAudioTrimmerAssetStatus::Failed;
+			InOutJob.Report.Reason = TEXT("reimport failed");
+			return false;
 		}
 
-		// Export the sound wave to a temporary WAV file
-		FString ExportPath = ExportSoundWaveToWav(SoundWave);
-		if (ExportPath.IsEmpty())
+		// Levels are kept with the asset on request, so later tools read them instead of decoding the audio again
+		if (InOutJob.Report.Stats.bIsValid
+			&& UAudioTrimmerSettings::Get().bWriteAudioStatsMetaData)
 		{
-			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to export %s. Skipping..."), *SoundWave->GetName());
-			continue;
+			WriteAudioStatsMetaData(SoundWave, InOutJob.Report.Stats);
 		}
 
-		// Calculate trim times
-		int32 StartTimeMs, EndTimeMs;
-		CalculateTrimTimes(LevelSequence, AudioSection, StartTimeMs, EndTimeMs);
-
-		const float StartTimeSec = StartTimeMs / 1000.0f;
-		const float EndTimeSec = EndTimeMs / 1000.0f;
-
-		FString TrimmedAudioPath = FPaths::ChangeExtension(ExportPath, TEXT("_trimmed.wav"));
-
-		// Trim the audio using the C++ function
-		if (!TrimAudio(ExportPath, TrimmedAudioPath, StartTimeSec, EndTimeSec))
+		// Save the reimported asset, so the journal state matches the content on disk
+		if (!UEditorLoadingAndSavingUtils::SavePackages({SoundWave->GetPackage()}, /*bOnlyDirty*/true))
 		{
-			UE_LOG(LogAudioTrimmer, Warning, TEXT("Trimming audio failed for %s. Skipping..."), *SoundWave->GetName());
-			continue;
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Saving trimmed %s failed, e.g. its file is read-only. Skipping..."), *SoundWave->GetName());
+			DeleteTempFiles();
+			InOutJob.Report.Status = EAudioTrimmerAssetStatus::Failed;
+			InOutJob.Report.Reason = TEXT("saving the sound wave failed");
+			return false;
 		}
+		Journal.Append(AssetPath, EAudioTrimmerJournalState::Reimported);
+
+		// Delete the temporary exported WAV files
+		DeleteTempFiles();
+	}
 
-		// Reimport the trimmed audio into the original sound wave asset using FReimportManager
-		if (!ReimportAudioToUnreal(SoundWave, TrimmedAudioPath))
+	// Rebase all sections onto the trimmed audio, using the exact start recorded when the audio was trimmed
+	const FString RecordedTrimStart = Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::TrimStartTimeSec);
+	const double TrimStartTimeSec = !RecordedTrimStart.IsEmpty() ? FCString::Atod(*RecordedTrimStart) : AssetPlan.StartTimeMs / 1000.0;
+	TArray<UPackage*> SectionPackages;
+	for (UMovieSceneAudioSection* AudioSection : AssetPlan.AudioSections)
+	{
+		// Sections that were rebased and saved before the interruption already differ from the planned offset
+		const FString PlannedOffset = Journal.GetValue(AssetPath, AudioTrimmerJournalKeys::SectionOffset + AudioSection->GetPathName());
+		if (!PlannedOffset.IsEmpty()
+			&& FCString::Atoi(*PlannedOffset) != AudioSection->GetStartOffset().Value)
 		{
-			UE_LOG(LogAudioTrimmer, Warning, TEXT("Reimporting trimmed audio failed for %s. Skipping..."), *SoundWave->GetName());
 			continue;
 		}
 
-		// Reset the Start Frame Offset for this audio section
-		ResetStartFrameOffset(AudioSection);
+		RebaseStartFrameOffsetBySeconds(AudioSection, TrimStartTimeSec);
+		SectionPackages.AddUnique(AudioSection->GetPackage());
+	}
 
-		// Delete the temporary exported WAV file
-		DeleteTempWavFile(ExportPath);
-		DeleteTempWavFile(TrimmedAudioPath);
+	// The sound wave is already trimmed on disk, so the journal keeps it Reimported until every rebased section is saved
+	if (!UEditorLoadingAndSavingUtils::SavePackages(SectionPackages, /*bOnlyDirty*/true))
+	{
+		UE_LOG(LogAudioTrimmer, Error, TEXT("Saving sections rebased onto trimmed %s failed, the next run finishes them."), *SoundWave->GetName());
+		InOutJob.Report.Status = EAudioTrimmerAssetStatus::Failed;
+		InOutJob.Report.Reason = TEXT("saving rebased sections failed");
+		return false;
 	}
+	Journal.Append(AssetPath, EAudioTrimmerJournalState::Committed);
+
+	InOutJob.Report.Status = EAudioTrimmerAssetStatus::Trimmed;
+	return true;
+}
 
-	UE_LOG(LogAudioTrimmer, Log, TEXT("Processing complete."));
+// Creates the report entry of the given plan with its original size and duration
+FAudioTrimmerAssetReport UAudioTrimmerUtilsLibrary::MakeAssetReport(const FAudioTrimmerAssetPlan& AssetPlan, EAudioTrimmerAssetStatus Status, const FString& Reason)
+{
+	FAudioTrimmerAssetReport AssetReport;
+	AssetReport.AssetPath = GetPathNameSafe(AssetPlan.SoundWave);
+	AssetReport.Status = Status;
+	AssetReport.Reason = Reason;
+	AssetReport.OriginalBytes = AssetPlan.SourceSizeBytes;
+	AssetReport.NewBytes = AssetPlan.SourceSizeBytes;
+	AssetReport.OriginalDurationSec = AssetPlan.DurationMs / 1000.0;
+	AssetReport.NewDurationSec = AssetReport.OriginalDurationSec;
+	AssetReport.UsedPercent = AssetPlan.GetUsedFraction() * 100.f;
+	return AssetReport;
 }
 
 // Retrieves all audio sections from the given level sequence
@@ -115,6 +931,149 @@ TArray<UMovieSceneAudioSection*> UAudioTrimmerUtilsLibrary::GetAudioSections(con
 	return AudioSections;
 }
 
+// Retrieves all audio sections that can be heard when the given level sequence is played, including its sub-sequences
+TArray<UMovieSceneAudioSection*> UAudioTrimmerUtilsLibrary::GetAudibleAudioSections(const ULevelSequence* LevelSequence)
+{
+	TSet<UMovieSceneAudioSection*> AudibleSections;
+	GetSectionRanges(LevelSequence, &AudibleSections);
+	return AudibleSections.Array();
+}
+
+// Returns the used frames of every audio section of the given level sequence and its sub-sequences
+TMap<UMovieSceneAudioSection*, TRange<FFrameNumber>> UAudioTrimmerUtilsLibrary::GetSectionRanges(const ULevelSequence* LevelSequence, TSet<UMovieSceneAudioSection*>* OutAudibleSections)
+{
+	const UMovieScene* MovieScene = LevelSequence ? LevelSequence->GetMovieScene() : nullptr;
+	if (!MovieScene)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Invalid LevelSequence."));
+		return {};
+	}
+
+	TMap<UMovieSceneAudioSection*, TRange<FFrameNumber>> SectionRanges;
+	TSet<UMovieSceneAudioSection*> AudibleSections;
+	AddSectionRanges(MovieScene, MovieScene->GetPlaybackRange(), /*bKeepFullRanges*/false, SectionRanges, AudibleSections);
+	if (OutAudibleSections)
+	{
+		*OutAudibleSections = MoveTemp(AudibleSections);
+	}
+	return SectionRanges;
+}
+
+// Adds the used frames of audio sections of the given movie scene and its sub-sequences
+void UAudioTrimmerUtilsLibrary::AddSectionRanges(const UMovieScene* MovieScene, const TRange<FFrameNumber>& ClipRange, bool bKeepFullRanges, TMap<UMovieSceneAudioSection*, TRange<FFrameNumber>>& InOutSectionRanges, TSet<UMovieSceneAudioSection*>& InOutAudibleSections, int32 Depth)
+{
+	// Deep enough for any real hierarchy, while a sequence that contains itself can never recurse forever
+	constexpr int32 MaxDepth = 16;
+	if (!MovieScene
+		|| Depth > MaxDepth)
+	{
+		return;
+	}
+
+	// Audio can be placed on root tracks as well as on tracks of bound actors
+	TArray<UMovieSceneTrack*> Tracks = MovieScene->GetTracks();
+	for (const FMovieSceneBinding& Binding : MovieScene->GetBindings())
+	{
+		Tracks.Append(Binding.GetTracks());
+	}
+
+	const TRange<FFrameNumber> PlaybackRange = MovieScene->GetPlaybackRange();
+	for (const UMovieSceneTrack* Track : Tracks)
+	{
+		if (!Track)
+		{
+			continue;
+		}
+
+		for (UMovieSceneSection* Section : Track->GetAllSections())
+		{
+			if (!Section)
+			{
+				continue;
+			}
+
+			// Infinite sections play through the whole movie scene
+			TRange<FFrameNumber> SectionRange = Section->GetRange();
+			if (!SectionRange.HasLowerBound())
+			{
+				SectionRange.SetLowerBound(PlaybackRange.GetLowerBound());
+			}
+			if (!SectionRange.HasUpperBound())
+			{
+				SectionRange.SetUpperBound(PlaybackRange.GetUpperBound());
+			}
+
+			// Muted and disabled tracks are never evaluated, but their sections still play the sound once enabled again
+			const bool bIsEvaluated = Section->IsActive()
+				&& !Track->IsEvalDisabled()
+				&& !Track->IsRowEvalDisabled(Section->GetRowIndex());
+			const TRange<FFrameNumber> AudibleRange = bIsEvaluated ? TRange<FFrameNumber>::Intersection(SectionRange, ClipRange) : TRange<FFrameNumber>::Empty();
+
+			if (UMovieSceneAudioSection* AudioSection = Cast<UMovieSceneAudioSection>(Section))
+			{
+				if (!AudibleRange.IsEmpty())
+				{
+					InOutAudibleSections.Add(AudioSection);
+				}
+
+				// Audibility only clips the section, so every section is rebased and keeps playing the same audio
+				const TRange<FFrameNumber> UsedRange = (bKeepFullRanges || AudibleRange.IsEmpty()) ? SectionRange : AudibleRange;
+				if (UsedRange.IsEmpty())
+				{
+					continue;
+				}
+
+				// A sub-sequence played several times is used in the hull of all its ranges
+				if (TRange<FFrameNumber>* ExistingRange = InOutSectionRanges.Find(AudioSection))
+				{
+					*ExistingRange = TRange<FFrameNumber>::Hull(*ExistingRange, UsedRange);
+				}
+				else
+				{
+					InOutSectionRanges.Add(AudioSection, UsedRange);
+				}
+			}
+			else if (const UMovieSceneSubSection* SubSection = Cast<UMovieSceneSubSection>(Section))
+			{
+				const UMovieSceneSequence* InnerSequence = SubSection->GetSequence();
+				const UMovieScene* InnerMovieScene = InnerSequence ? InnerSequence->GetMovieScene() : nullptr;
+				if (!InnerMovieScene)
+				{
+					continue;
+				}
+
+				// Map the clipped part of the sub-section into the frames of the inner sequence
+				const TRange<FFrameNumber> InnerPlaybackRange = InnerMovieScene->GetPlaybackRange();
+				TRange<FFrameNumber> InnerClipRange = AudibleRange.IsEmpty() ? TRange<FFrameNumber>::Empty() : InnerPlaybackRange;
+				const float TimeScale = SubSection->Parameters.TimeScale;
+				if (!AudibleRange.IsEmpty()
+					&& !SubSection->Parameters.bCanLoop
+					&& TimeScale > 0.f
+					&& SubSection->HasStartFrame())
+				{
+					const FFrameRate OuterTickResolution = MovieScene->GetTickResolution();
+					const FFrameRate InnerTickResolution = InnerMovieScene->GetTickResolution();
+					const FFrameNumber InnerStartFrame = UE::MovieScene::DiscreteInclusiveLower(InnerPlaybackRange) + SubSection->Parameters.StartFrameOffset;
+					auto ToInnerTime = [&](FFrameNumber OuterFrame)
+					{
+						const FFrameTime OuterElapsed = OuterFrame - SubSection->GetInclusiveStartFrame();
+						return InnerStartFrame + FFrameRate::TransformTime(OuterElapsed, OuterTickResolution, InnerTickResolution) * TimeScale;
+					};
+
+					const TRange<FFrameNumber> OuterRange(
+						ToInnerTime(UE::MovieScene::DiscreteInclusiveLower(AudibleRange)).FloorToFrame(),
+						ToInnerTime(UE::MovieScene::DiscreteExclusiveUpper(AudibleRange)).CeilToFrame());
+					InnerClipRange = TRange<FFrameNumber>::Intersection(OuterRange, InnerPlaybackRange);
+				}
+
+				// A sub-sequence of another package may be played by other parents as well, so this parent never clips its sections
+				const bool bInnerKeepsFullRanges = bKeepFullRanges || InnerMovieScene->GetPackage() != MovieScene->GetPackage();
+				AddSectionRanges(InnerMovieScene, InnerClipRange, bInnerKeepsFullRanges, InOutSectionRanges, InOutAudibleSections, Depth + 1);
+			}
+		}
+	}
+}
+
 //Calculates the start and end times in milliseconds for trimming an audio section
 void UAudioTrimmerUtilsLibrary::CalculateTrimTimes(const ULevelSequence* LevelSequence, UMovieSceneAudioSection* AudioSection, int32& StartTimeMs, int32& EndTimeMs)
 {
@@ -124,49 +1083,225 @@ void UAudioTrimmerUtilsLibrary::CalculateTrimTimes(const ULevelSequence* LevelSe
 		return;
 	}
 
-	const FFrameRate TickResolution = LevelSequence->GetMovieScene()->GetTickResolution();
+	const TRange<FFrameNumber>* SectionRange = GetSectionRanges(LevelSequence).Find(AudioSection);
+	if (!SectionRange)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("AudioSection is not part of %s."), *LevelSequence->GetName());
+		return;
+	}
+
+	CalculateSectionTrimTimes(AudioSection, *SectionRange, StartTimeMs, EndTimeMs);
+}
+
+// Calculates the start and end times in milliseconds of the sound played by the given used part of an audio section
+void UAudioTrimmerUtilsLibrary::CalculateSectionTrimTimes(const UMovieSceneAudioSection* AudioSection, const TRange<FFrameNumber>& SectionRange, int32& StartTimeMs, int32& EndTimeMs)
+{
+	const UMovieScene* MovieScene = AudioSection ? AudioSection->GetTypedOuter<UMovieScene>() : nullptr;
+	if (!MovieScene
+		|| SectionRange.IsEmpty()
+		|| !SectionRange.GetLowerBound().IsClosed()
+		|| !SectionRange.GetUpperBound().IsClosed())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Invalid AudioSection or SectionRange."));
+		return;
+	}
+
+	const USoundWave* SoundWave = Cast<USoundWave>(AudioSection->GetSound());
+	if (!SoundWave)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("SoundWave is null or invalid."));
+		return;
+	}
+
+	// Sections of sub-sequences are measured in the tick resolution of their own movie scene
+	const FFrameRate TickResolution = MovieScene->GetTickResolution();
+	const FFrameNumber UsedStartFrame = UE::MovieScene::DiscreteInclusiveLower(SectionRange);
+	const FFrameNumber UsedEndFrame = UE::MovieScene::DiscreteExclusiveUpper(SectionRange);
+
+	// The sound starts at the start offset when the section starts, so the clipped head moves the used start further by the audio it played
+	const FFrameNumber SectionStartFrame = AudioSection->HasStartFrame() ? AudioSection->GetInclusiveStartFrame() : UsedStartFrame;
+	const double StartOffsetSeconds = TickResolution.AsSeconds(AudioSection->GetStartOffset());
+	const double AudioStartOffsetSeconds = StartOffsetSeconds + GetPlayedAudioSeconds(AudioSection, SectionStartFrame, UsedStartFrame);
+	double AudioEndSeconds = AudioStartOffsetSeconds + GetPlayedAudioSeconds(AudioSection, UsedStartFrame, UsedEndFrame);
+
+	// Total duration of the audio in seconds
+	const double TotalAudioDurationSeconds = SoundWave->Duration;
+
+	if (AudioSection->GetLooping()
+		&& AudioEndSeconds > TotalAudioDurationSeconds)
+	{
+		// Once a looping section reaches the end, the sound starts over from its beginning, so all of it is heard
+		StartTimeMs = 0;
+		EndTimeMs = static_cast<int32>(TotalAudioDurationSeconds * 1000.0);
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Audio: %s, Section loops, the whole sound is used"), *SoundWave->GetName());
+		return;
+	}
+
+	// Adjust the end time if it exceeds the total length of the audio
+	AudioEndSeconds = FMath::Min(AudioEndSeconds, TotalAudioDurationSeconds);
 
-	// Get the audio start offset in frames (relative to the audio asset)
-	const int32 AudioStartOffsetFrames = AudioSection->GetStartOffset().Value;
-	const float AudioStartOffsetSeconds = AudioStartOffsetFrames / TickResolution.AsDecimal();
+	// Calculate the start and end times in milliseconds, the start is rounded down and the end up, so no played sample is cut
+	StartTimeMs = FMath::FloorToInt32(FMath::Min(AudioStartOffsetSeconds, AudioEndSeconds) * 1000.0);
+	EndTimeMs = FMath::CeilToInt32(AudioEndSeconds * 1000.0);
 
-	// Get the duration of the section on the track (in frames)
-	const int32 SectionDurationFrames = (AudioSection->GetExclusiveEndFrame() - AudioSection->GetInclusiveStartFrame()).Value;
-	const float SectionDurationSeconds = SectionDurationFrames / TickResolution.AsDecimal();
+	// Calculate the percentage of the audio that is used
+	const double UsedPercentage = TotalAudioDurationSeconds > 0.0 ? (AudioEndSeconds - AudioStartOffsetSeconds) / TotalAudioDurationSeconds * 100.0 : 100.0;
 
-	// Calculate the effective end time within the audio asset
-	float AudioEndSeconds = AudioStartOffsetSeconds + SectionDurationSeconds;
+	// Log the start and end times in milliseconds, section duration, and percentage used
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Audio: %s, Used from %.2f seconds to %.2f seconds (Duration: %.2f seconds), Percentage Used: %.2f%%"),
+	       *SoundWave->GetName(), AudioStartOffsetSeconds, AudioEndSeconds, AudioEndSeconds - AudioStartOffsetSeconds, UsedPercentage);
+}
 
-	if (const USoundWave* SoundWave = Cast<USoundWave>(AudioSection->GetSound()))
+// Returns how many seconds of the sound are played by the section between the given frames, following its pitch
+double UAudioTrimmerUtilsLibrary::GetPlayedAudioSeconds(const UMovieSceneAudioSection* AudioSection, FFrameNumber StartFrame, FFrameNumber EndFrame)
+{
+	const UMovieScene* MovieScene = AudioSection ? AudioSection->GetTypedOuter<UMovieScene>() : nullptr;
+	if (!MovieScene
+		|| EndFrame <= StartFrame)
 	{
-		// Total duration of the audio in seconds
-		const float TotalAudioDurationSeconds = SoundWave->Duration;
+		return 0.0;
+	}
 
-		// Adjust the end time if it exceeds the total length of the audio
-		if (AudioEndSeconds > TotalAudioDurationSeconds)
-		{
-			AudioEndSeconds = TotalAudioDurationSeconds;
-		}
+	const FFrameRate TickResolution = MovieScene->GetTickResolution();
+	const double DurationSeconds = TickResolution.AsSeconds(EndFrame - StartFrame);
 
-		// Calculate the start and end times in milliseconds
-		StartTimeMs = static_cast<int32>(AudioStartOffsetSeconds * 1000.0f);
-		EndTimeMs = static_cast<int32>(AudioEndSeconds * 1000.0f);
+	// The audio engine clamps every pitch, so the same clamp keeps the played length exact for extreme keys
+	const UAudioSettings* AudioSettings = GetDefault<UAudioSettings>();
+	const float MinPitch = AudioSettings->GlobalMinPitchScale;
+	const float MaxPitch = AudioSettings->GlobalMaxPitchScale;
 
-		// Calculate the percentage of the audio that is used
-		const float UsedPercentage = ((AudioEndSeconds - AudioStartOffsetSeconds) / TotalAudioDurationSeconds) * 100.0f;
+	const USoundWave* SoundWave = Cast<USoundWave>(AudioSection->GetSound());
+	const float SoundPitch = SoundWave ? SoundWave->Pitch : 1.f;
+	const FMovieSceneFloatChannel& PitchChannel = AudioSection->GetPitchMultiplierChannel();
 
-		// Log the start and end times in milliseconds, section duration, and percentage used
-		UE_LOG(LogAudioTrimmer, Log, TEXT("Audio: %s, Used from %.2f seconds to %.2f seconds (Duration: %.2f seconds), Percentage Used: %.2f%%"),
-		       *SoundWave->GetName(), AudioStartOffsetSeconds, AudioEndSeconds, AudioEndSeconds - AudioStartOffsetSeconds, UsedPercentage);
+	// Without keys the pitch is constant, the played length is exact
+	if (PitchChannel.GetNumKeys() == 0)
+	{
+		float Pitch = 1.f;
+		PitchChannel.Evaluate(StartFrame, Pitch);
+		return DurationSeconds * FMath::Clamp(Pitch * SoundPitch, MinPitch, MaxPitch);
 	}
-	else
+
+	// Integrate the pitch curve with the trapezoidal rule over small steps, which is exact for linear keys
+	constexpr double StepSeconds = 1.0 / 240.0;
+	const int32 NumSteps = FMath::Max(FMath::CeilToInt32(DurationSeconds / StepSeconds), 1);
+	const FFrameTime StepTime = FFrameTime::FromDecimal(static_cast<double>((EndFrame - StartFrame).Value) / NumSteps);
+
+	auto EvaluatePitch = [&](const FFrameTime& Time)
 	{
-		UE_LOG(LogAudioTrimmer, Warning, TEXT("SoundWave is null or invalid."));
+		float Pitch = 1.f;
+		PitchChannel.Evaluate(Time, Pitch);
+		return static_cast<double>(FMath::Clamp(Pitch * SoundPitch, MinPitch, MaxPitch));
+	};
+
+	double PlayedSeconds = 0.0;
+	double PreviousPitch = EvaluatePitch(StartFrame);
+	for (int32 StepIndex = 1; StepIndex <= NumSteps; ++StepIndex)
+	{
+		const FFrameTime Time = StepIndex == NumSteps ? FFrameTime(EndFrame) : FFrameTime(StartFrame) + StepTime * StepIndex;
+		const double CurrentPitch = EvaluatePitch(Time);
+		PlayedSeconds += (PreviousPitch + CurrentPitch) * 0.5;
+		PreviousPitch = CurrentPitch;
 	}
+
+	return PlayedSeconds * DurationSeconds / NumSteps;
 }
 
 // Trims an audio file to the specified start and end times
 bool UAudioTrimmerUtilsLibrary::TrimAudio(const FString& InputPath, const FString& OutputPath, float StartTimeSec, float EndTimeSec)
+{
+	// Uncompressed WAV files are streamed in-process with constant memory usage, anything else goes through ffmpeg
+	FAudioTrimmerWavHeader Header;
+	if (FAudioTrimmerWav::ReadHeader(InputPath, Header)
+		&& Header.IsUncompressed())
+	{
+		FAudioTrimmerFrameRange FrameRange(FMath::RoundToInt64(StartTimeSec * Header.SampleRate), FMath::RoundToInt64(EndTimeSec * Header.SampleRate));
+		if (!TrimAudioFrames(InputPath, OutputPath, FrameRange))
+		{
+			return false;
+		}
+	}
+	else if (!TrimAudioWithFfmpeg(InputPath, OutputPath, StartTimeSec, EndTimeSec))
+	{
+		return false;
+	}
+
+	const float PrevSizeMB = IFileManager::Get().FileSize(*InputPath) / (1024.f * 1024.f);
+	const float NewSizeMB = IFileManager::Get().FileSize(*OutputPath) / (1024.f * 1024.f);
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Trimmed audio stats: Previous Size: %.2f MB, New Size: %.2f MB"), PrevSizeMB, NewSizeMB);
+
+	return true;
+}
+
+// Trims an uncompressed WAV file to the given frames in-process, applying the click-free cut options from the settings
+bool UAudioTrimmerUtilsLibrary::TrimAudioFrames(const FString& InputPath, const FString& OutputPath, FAudioTrimmerFrameRange& InOutFrameRange, const FString& SourceHash, FAudioTrimmerAudioStats* OutStats)
+{
+	FAudioTrimmerWavHeader Header;
+	if (!FAudioTrimmerWav::ReadHeader(InputPath, Header))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to read WAV header: %s"), *InputPath);
+		return false;
+	}
+
+	const UAudioTrimmerSettings& Settings = UAudioTrimmerSettings::Get();
+	const int64 TotalFrames = Header.GetNumFrames();
+	InOutFrameRange = FAudioTrimmerFrameRange(FMath::Clamp<int64>(InOutFrameRange.StartFrame, 0, TotalFrames), FMath::Clamp<int64>(InOutFrameRange.EndFrame, 0, TotalFrames));
+
+	// The same source and range was already trimmed on this or another machine
+	const FString CacheKey = !SourceHash.IsEmpty() && FAudioTrimmerCache::IsEnabled() ? FAudioTrimmerCache::MakeKey(SourceHash, InOutFrameRange) : FString();
+	if (!CacheKey.IsEmpty()
+		&& FAudioTrimmerCache::Get(CacheKey, OutputPath, InOutFrameRange, OutStats))
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Trimmed audio is taken from the cache: %s"), *OutputPath);
+		return true;
+	}
+
+	if (Settings.bSnapToZeroCrossings)
+	{
+		const int64 WindowFrames = FMath::RoundToInt64(Settings.ZeroCrossingWindowMs / 1000.0 * Header.SampleRate);
+		FAudioTrimmerDsp::SnapToZeroCrossings(InputPath, InOutFrameRange, WindowFrames);
+	}
+
+	// Levels are measured before the edge fades, which only soften a few milliseconds at the cuts
+	FAudioTrimmerAnalyzer Analyzer;
+	const bool bAnalyze = OutStats
+		&& Settings.bAnalyzeTrimmedAudio
+		&& Analyzer.Init(Header.NumChannels, Header.SampleRate, Settings.SilenceThresholdDb);
+
+	if (!FAudioTrimmerWav::CopyFrameRanges(InputPath, OutputPath, {InOutFrameRange}, bAnalyze ? &Analyzer : nullptr))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to trim audio in-process: %s"), *InputPath);
+		return false;
+	}
+
+	if (bAnalyze)
+	{
+		*OutStats = Analyzer.GetStats();
+	}
+
+	// Fade only the edges that were actually cut
+	if (Settings.bApplyEdgeFades)
+	{
+		const int64 FadeFrames = FMath::RoundToInt64(Settings.EdgeFadeMs / 1000.0 * Header.SampleRate);
+		const int64 FadeInFrames = InOutFrameRange.StartFrame > 0 ? FadeFrames : 0;
+		const int64 FadeOutFrames = InOutFrameRange.EndFrame < TotalFrames ? FadeFrames : 0;
+		if (!FAudioTrimmerDsp::ApplyEdgeFades(OutputPath, FadeInFrames, FadeOutFrames))
+		{
+			UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to fade edges of trimmed audio: %s"), *OutputPath);
+		}
+	}
+
+	if (!CacheKey.IsEmpty())
+	{
+		FAudioTrimmerCache::Put(CacheKey, OutputPath, InOutFrameRange, OutStats);
+	}
+
+	return true;
+}
+
+// Trims an audio file to the specified start and end times using the ffmpeg executable
+bool UAudioTrimmerUtilsLibrary::TrimAudioWithFfmpeg(const FString& InputPath, const FString& OutputPath, float StartTimeSec, float EndTimeSec)
 {
 	int32 ReturnCode;
 	FString Output;
@@ -184,10 +1319,60 @@ bool UAudioTrimmerUtilsLibrary::TrimAudio(const FString& InputPath, const FStrin
 		return false;
 	}
 
+	return true;
+}
+
+// Trims audio in memory by streaming it through the standard input and output of the ffmpeg executable
+bool UAudioTrimmerUtilsLibrary::TrimAudioWithFfmpegPipes(TConstArrayView<uint8> InputBytes, TArray<uint8>& OutBytes, const FAudioTrimmerFrameRange& FrameRange)
+{
+	// Seeking is not possible on a pipe, so the cut is made at exact samples while decoding
+	const FString Filters = FString::Printf(TEXT("-af atrim=start_sample=%lld:end_sample=%lld,asetpts=PTS-STARTPTS"), FrameRange.StartFrame, FrameRange.EndFrame);
+	if (!AudioTrimmerFfmpeg::RunWithPipes(InputBytes, OutBytes, Filters))
+	{
+		return false;
+	}
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Trimmed piped audio stats: Previous Size: %.2f MB, New Size: %.2f MB"), InputBytes.Num() / (1024.f * 1024.f), OutBytes.Num() / (1024.f * 1024.f));
+	return true;
+}
+
+// Decodes the whole audio in memory by streaming it through the standard input and output of the ffmpeg executable
+bool UAudioTrimmerUtilsLibrary::DecodeAudioWithFfmpegPipes(TConstArrayView<uint8> InputBytes, TArray<uint8>& OutBytes)
+{
+	return AudioTrimmerFfmpeg::RunWithPipes(InputBytes, OutBytes, FString());
+}
+
+// Returns true if any enabled setting works on the samples of the trimmed audio
+bool UAudioTrimmerUtilsLibrary::IsDecodedSourceRequired()
+{
+	const UAudioTrimmerSettings& Settings = UAudioTrimmerSettings::Get();
+	return FAudioTrimmerCache::IsEnabled()
+		|| Settings.bSnapToZeroCrossings
+		|| Settings.bApplyEdgeFades
+		|| Settings.bVerifyTrimmedAudio
+		|| Settings.bDownmixFakeStereo
+		|| Settings.bResampleToTargetRate;
+}
+
+// Converts the sample rate of an uncompressed WAV file
+bool UAudioTrimmerUtilsLibrary::ResampleAudio(const FString& InputPath, const FString& OutputPath, int32 TargetSampleRate)
+{
+	if (TargetSampleRate <= 0)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Invalid target sample rate: %d"), TargetSampleRate);
+		return false;
+	}
+
+	if (!FAudioTrimmerResampler::ResampleFile(InputPath, OutputPath, TargetSampleRate))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to resample audio to %d Hz: %s"), TargetSampleRate, *InputPath);
+		return false;
+	}
+
 	const float PrevSizeMB = IFileManager::Get().FileSize(*InputPath) / (1024.f * 1024.f);
 	const float NewSizeMB = IFileManager::Get().FileSize(*OutputPath) / (1024.f * 1024.f);
 
-	UE_LOG(LogAudioTrimmer, Log, TEXT("Trimmed audio stats: Previous Size: %.2f MB, New Size: %.2f MB"), PrevSizeMB, NewSizeMB);
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Resampled audio stats: Previous Size: %.2f MB, New Size: %.2f MB"), PrevSizeMB, NewSizeMB);
 
 	return true;
 }
@@ -201,10 +1386,7 @@ FString UAudioTrimmerUtilsLibrary::ExportSoundWaveToWav(USoundWave* SoundWave)
 		return FString();
 	}
 
-	const FString PackagePath = SoundWave->GetPathName();
-	const FString RelativePath = FPackageName::LongPackageNameToFilename(PackagePath, TEXT(""));
-	const FString FullPath = FPaths::ChangeExtension(RelativePath, TEXT("wav"));
-	const FString ExportPath = FPaths::ConvertRelativePathToFull(FullPath);
+	const FString ExportPath = GetExportPath(SoundWave);
 
 	// Export the sound wave to the WAV file
 	UAssetExportTask* ExportTask = NewObject<UAssetExportTask>();
@@ -230,6 +1412,15 @@ FString UAudioTrimmerUtilsLibrary::ExportSoundWaveToWav(USoundWave* SoundWave)
 	return FString();
 }
 
+// Returns the path of the WAV file the given sound wave is exported to
+FString UAudioTrimmerUtilsLibrary::GetExportPath(const USoundWave* SoundWave)
+{
+	const FString PackagePath = GetPathNameSafe(SoundWave);
+	const FString RelativePath = FPackageName::LongPackageNameToFilename(PackagePath, TEXT(""));
+	const FString FullPath = FPaths::ChangeExtension(RelativePath, TEXT("wav"));
+	return FPaths::ConvertRelativePathToFull(FullPath);
+}
+
 // Reimports an audio file into the original sound wave asset in Unreal Engine
 bool UAudioTrimmerUtilsLibrary::ReimportAudioToUnreal(USoundWave* OriginalSoundWave, const FString& TrimmedAudioFilePath)
 {
@@ -262,6 +1453,66 @@ bool UAudioTrimmerUtilsLibrary::ReimportAudioToUnreal(USoundWave* OriginalSoundW
 	return true;
 }
 
+// Replaces the source audio of the sound wave with the given WAV data without going through a file
+bool UAudioTrimmerUtilsLibrary::ReimportAudioFromMemory(USoundWave* SoundWave, const TArray<uint8>& WavBytes)
+{
+	if (!SoundWave)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Original SoundWave is null."));
+		return false;
+	}
+
+	SoundWave->Modify();
+	if (!SetSoundWavePayload(SoundWave, WavBytes))
+	{
+		return false;
+	}
+	SoundWave->PostEditChange();
+	SoundWave->MarkPackageDirty();
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Successfully reimported asset: %s from memory"), *SoundWave->GetName());
+	return true;
+}
+
+// Replaces the source audio of the sound wave with the given WAV data and updates the properties derived from it
+bool UAudioTrimmerUtilsLibrary::SetSoundWavePayload(USoundWave* SoundWave, const TArray<uint8>& WavBytes)
+{
+	FAudioTrimmerWavHeader Header;
+	if (!SoundWave
+		|| !FAudioTrimmerWav::ReadHeader(WavBytes, Header)
+		|| !Header.IsUncompressed()
+		|| Header.SampleRate == 0)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Trimmed audio of %s is not an uncompressed WAV file."), *GetNameSafe(SoundWave));
+		return false;
+	}
+
+	// Same properties the sound factory updates on reimport, platform data is rebuilt from the new payload
+	SoundWave->RawData.UpdatePayload(FSharedBuffer::Clone(WavBytes.GetData(), WavBytes.Num()));
+	SoundWave->NumChannels = Header.NumChannels;
+	SoundWave->SetSampleRate(Header.SampleRate);
+	SoundWave->Duration = static_cast<float>(Header.GetNumFrames()) / Header.SampleRate;
+	SoundWave->TotalSamples = Header.SampleRate * SoundWave->Duration;
+	SoundWave->InvalidateCompressedData(/*bFreeResources*/true);
+	return true;
+}
+
+// Stores the levels of the trimmed audio in the package metadata of the sound wave
+void UAudioTrimmerUtilsLibrary::WriteAudioStatsMetaData(USoundWave* SoundWave, const FAudioTrimmerAudioStats& Stats)
+{
+	UMetaData* MetaData = SoundWave ? SoundWave->GetPackage()->GetMetaData() : nullptr;
+	if (!MetaData)
+	{
+		return;
+	}
+
+	MetaData->SetValue(SoundWave, TEXT("AudioTrimmer.PeakDbfs"), *LexToSanitizedString(Stats.PeakDbfs));
+	MetaData->SetValue(SoundWave, TEXT("AudioTrimmer.RmsDbfs"), *LexToSanitizedString(Stats.RmsDbfs));
+	MetaData->SetValue(SoundWave, TEXT("AudioTrimmer.IntegratedLufs"), *LexToSanitizedString(Stats.IntegratedLufs));
+	MetaData->SetValue(SoundWave, TEXT("AudioTrimmer.SilencePercent"), *LexToSanitizedString(Stats.SilencePercent));
+	SoundWave->MarkPackageDirty();
+}
+
 // Resets the start frame offset of an audio section to zero
 void UAudioTrimmerUtilsLibrary::ResetStartFrameOffset(UMovieSceneAudioSection* AudioSection)
 {
@@ -286,6 +1537,33 @@ void UAudioTrimmerUtilsLibrary::ResetStartFrameOffset(UMovieSceneAudioSection* A
 	UE_LOG(LogAudioTrimmer, Log, TEXT("Reset Start Frame Offset for section using sound: %s"), *AudioSection->GetSound()->GetName());
 }
 
+// Shifts the start frame offset of an audio section by the time trimmed from the beginning of its sound
+void UAudioTrimmerUtilsLibrary::RebaseStartFrameOffset(UMovieSceneAudioSection* AudioSection, int32 TrimStartTimeMs)
+{
+	RebaseStartFrameOffsetBySeconds(AudioSection, TrimStartTimeMs / 1000.0);
+}
+
+// Shifts the start frame offset of an audio section by the exact time trimmed from the beginning of its sound
+void UAudioTrimmerUtilsLibrary::RebaseStartFrameOffsetBySeconds(UMovieSceneAudioSection* AudioSection, double TrimStartTimeSec)
+{
+	const UMovieScene* MovieScene = AudioSection ? AudioSection->GetTypedOuter<UMovieScene>() : nullptr;
+	if (!MovieScene)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Invalid AudioSection."));
+		return;
+	}
+
+	const FFrameRate TickResolution = MovieScene->GetTickResolution();
+	const FFrameNumber TrimStartFrames = TickResolution.AsFrameNumber(TrimStartTimeSec);
+	const FFrameNumber NewStartOffset = FMath::Max(AudioSection->GetStartOffset() - TrimStartFrames, FFrameNumber(0));
+
+	AudioSection->SetStartOffset(NewStartOffset);
+	AudioSection->MarkAsChanged();
+	MovieScene->MarkPackageDirty();
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Rebased Start Frame Offset to %d for section using sound: %s"), NewStartOffset.Value, *GetNameSafe(AudioSection->GetSound()));
+}
+
 // Deletes a temporary WAV file from the file system
 bool UAudioTrimmerUtilsLibrary::DeleteTempWavFile(const FString& FilePath)
 {
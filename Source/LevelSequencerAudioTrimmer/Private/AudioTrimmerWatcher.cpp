@@ -0,0 +1,297 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerWatcher.h"
+//---
+#include "AudioTrimmerSettings.h"
+#include "AudioTrimmerSubsystem.h"
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "AssetRegistry/IAssetRegistry.h"
+#include "Editor.h"
+#include "LevelSequence.h"
+#include "Misc/PackageName.h"
+#include "Sections/MovieSceneAudioSection.h"
+#include "Sound/SoundWave.h"
+#include "UObject/ObjectSaveContext.h"
+#include "UObject/Package.h"
+
+// Returns true if this process is an interactive editor and watching is enabled in the settings
+bool FAudioTrimmerWatcher::ShouldWatch()
+{
+	return GIsEditor
+		&& !IsRunningCommandlet()
+		&& UAudioTrimmerSettings::Get().bWatchLevelSequences;
+}
+
+// Loads the usage manifest, starts listening for saved level sequences and refreshes the manifest once the asset registry finished loading
+void FAudioTrimmerWatcher::Start()
+{
+	Manifest.Load();
+
+	OnPackageSavedHandle = UPackage::PackageSavedWithContextEvent.AddRaw(this, &FAudioTrimmerWatcher::OnPackageSaved);
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FAudioTrimmerWatcher::Tick), /*InDelay*/1.f);
+
+	// Changed sequences are found through the asset registry, so the refresh waits for its initial scan instead of forcing a synchronous one
+	IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+	if (AssetRegistry.IsLoadingAssets())
+	{
+		OnFilesLoadedHandle = AssetRegistry.OnFilesLoaded().AddRaw(this, &FAudioTrimmerWatcher::StartRefresh);
+	}
+	else
+	{
+		StartRefresh();
+	}
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Watching saved level sequences to trim sound waves whose used range shrank."));
+}
+
+// Stops listening, drops queued sound waves and saves the usage manifest if it changed
+void FAudioTrimmerWatcher::Stop()
+{
+	UPackage::PackageSavedWithContextEvent.Remove(OnPackageSavedHandle);
+	OnPackageSavedHandle.Reset();
+
+	if (IAssetRegistry* AssetRegistry = IAssetRegistry::Get())
+	{
+		AssetRegistry->OnFilesLoaded().Remove(OnFilesLoadedHandle);
+	}
+	OnFilesLoadedHandle.Reset();
+
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	TickerHandle.Reset();
+
+	QueuedSounds.Empty();
+
+	// Sequences still waiting for the refresh keep their previous state, so they are found again by the next session
+	SequencesToRefresh.Empty();
+
+	if (bManifestDirty)
+	{
+		Manifest.Save();
+		bManifestDirty = false;
+	}
+}
+
+// Collects level sequences changed since the last session, they are loaded in the background by the ticker
+void FAudioTrimmerWatcher::StartRefresh()
+{
+	if (IAssetRegistry* AssetRegistry = IAssetRegistry::Get())
+	{
+		AssetRegistry->OnFilesLoaded().Remove(OnFilesLoadedHandle);
+	}
+	OnFilesLoadedHandle.Reset();
+
+	int32 NumRemoved = 0;
+	for (const FAssetData& AssetData : Manifest.CollectChangedSequences(TEXT("/Game"), NumRemoved))
+	{
+		SequencesToRefresh.Add(AssetData.PackageName);
+	}
+
+	bManifestDirty |= NumRemoved > 0;
+
+	UE_LOG(LogAudioTrimmer, Log, TEXT("Usage manifest is being refreshed: %d level sequences changed, %d removed."), SequencesToRefresh.Num(), NumRemoved);
+}
+
+// Starts loading the next changed level sequences, up to the prefetch count from the settings
+void FAudioTrimmerWatcher::LoadSequencesToRefresh()
+{
+	const int32 MaxLoads = FMath::Max(UAudioTrimmerSettings::Get().PrefetchCount, 1);
+	while (NumRefreshLoads < MaxLoads
+		&& !SequencesToRefresh.IsEmpty())
+	{
+		++NumRefreshLoads;
+
+		// The watcher can be stopped and destroyed before the load completes
+		LoadPackageAsync(SequencesToRefresh.Pop(EAllowShrinking::No).ToString(), FLoadPackageAsyncDelegate::CreateSP(this, &FAudioTrimmerWatcher::OnRefreshSequenceLoaded));
+	}
+}
+
+// Is called once a changed level sequence is loaded to update its usage in the manifest
+void FAudioTrimmerWatcher::OnRefreshSequenceLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+{
+	--NumRefreshLoads;
+
+	const ULevelSequence* LevelSequence = Package && Result == EAsyncLoadingResult::Succeeded ? Cast<ULevelSequence>(Package->FindAssetInPackage()) : nullptr;
+	if (!LevelSequence)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to load level sequence %s while refreshing the usage manifest. Skipping..."), *PackageName.ToString());
+		return;
+	}
+
+	// Only usage is kept, the sequence is unloaded by the next garbage collection of the editor
+	Manifest.UpdateSequence(LevelSequence);
+	bManifestDirty = true;
+
+	if (!IsRefreshing())
+	{
+		UE_LOG(LogAudioTrimmer, Log, TEXT("Usage manifest refreshed: %d level sequences."), Manifest.GetSequences().Num());
+	}
+}
+
+// Is called after any package is saved to queue sound waves whose used range shrank
+void FAudioTrimmerWatcher::OnPackageSaved(const FString& PackageFilename, UPackage* Package, FObjectPostSaveContext ObjectSaveContext)
+{
+	const ULevelSequence* LevelSequence = Package && !ObjectSaveContext.IsProceduralSave() ? Cast<ULevelSequence>(Package->FindAssetInPackage()) : nullptr;
+	if (!LevelSequence)
+	{
+		return;
+	}
+
+	// Sound waves used by the sequence before or after the save are the only ones whose range could change
+	TSet<FString> AffectedSounds;
+	if (const FAudioTrimmerSequenceUsage* PreviousUsage = Manifest.GetSequences().Find(Package->GetName()))
+	{
+		for (const FAudioTrimmerSectionUsage& SectionUsage : PreviousUsage->Sections)
+		{
+			AffectedSounds.Add(SectionUsage.SoundWavePath);
+		}
+	}
+
+	const TMap<FString, FAudioTrimmerFrameRange> PreviousRanges = GetUsedRanges(AffectedSounds);
+
+	Manifest.UpdateSequence(LevelSequence);
+	bManifestDirty = true;
+
+	// Saves made by a trimming job rebase sections onto already trimmed audio, that is not a shrink
+	const UAudioTrimmerSubsystem* Subsystem = UAudioTrimmerSubsystem::Get();
+	if (Subsystem
+		&& Subsystem->IsRunningJob())
+	{
+		return;
+	}
+
+	for (const FAudioTrimmerSectionUsage& SectionUsage : Manifest.GetSequences().FindChecked(Package->GetName()).Sections)
+	{
+		AffectedSounds.Add(SectionUsage.SoundWavePath);
+	}
+
+	const TMap<FString, FAudioTrimmerFrameRange> NewRanges = GetUsedRanges(AffectedSounds);
+	for (const TTuple<FString, FAudioTrimmerFrameRange>& It : NewRanges)
+	{
+		// New sounds and sounds that are used more are left for the next full run
+		const FAudioTrimmerFrameRange* PreviousRange = PreviousRanges.Find(It.Key);
+		if (PreviousRange
+			&& (It.Value.StartFrame > PreviousRange->StartFrame || It.Value.EndFrame < PreviousRange->EndFrame))
+		{
+			UE_LOG(LogAudioTrimmer, Log, TEXT("Used range of %s shrank in %s, queued for trimming."), *It.Key, *LevelSequence->GetName());
+			QueuedSounds.Add(It.Key);
+		}
+	}
+
+	LastSaveTime = FPlatformTime::Seconds();
+}
+
+// Is called by the ticker to refresh the manifest, save it and trim queued sound waves once no package was saved for a while
+bool FAudioTrimmerWatcher::Tick(float DeltaTime)
+{
+	LoadSequencesToRefresh();
+
+	// Never interrupt playing in editor or another slow task
+	if (FPlatformTime::Seconds() - LastSaveTime < UAudioTrimmerSettings::Get().WatchDelaySeconds
+		|| (GEditor && GEditor->PlayWorld)
+		|| GIsSlowTask)
+	{
+		return true;
+	}
+
+	// The manifest is written once per burst of saves instead of after every saved sequence
+	if (bManifestDirty
+		&& !IsRefreshing())
+	{
+		Manifest.Save();
+		bManifestDirty = false;
+	}
+
+	// A sequence that was not refreshed yet could still play a queued sound, so its used range is not final
+	if (!QueuedSounds.IsEmpty()
+		&& !IsRefreshing())
+	{
+		TrimQueuedSounds();
+	}
+
+	return true;
+}
+
+// Submits one job that loads all level sequences playing queued sound waves and trims those sound waves
+void FAudioTrimmerWatcher::TrimQueuedSounds()
+{
+	UAudioTrimmerSubsystem* Subsystem = UAudioTrimmerSubsystem::Get();
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	TSet<FString> SoundsToTrim = MoveTemp(QueuedSounds);
+	QueuedSounds.Reset();
+
+	// A shared sound wave is trimmed to the union of all its sections, so every sequence that plays it is included
+	TSet<FString> SequencesToLoad;
+	TArray<FSoftObjectPath> SequencesToPrefetch;
+	for (const TTuple<FString, FAudioTrimmerSequenceUsage>& It : Manifest.GetSequences())
+	{
+		for (const FAudioTrimmerSectionUsage& SectionUsage : It.Value.Sections)
+		{
+			if (SoundsToTrim.Contains(SectionUsage.SoundWavePath))
+			{
+				SequencesToLoad.Add(It.Key);
+				SequencesToPrefetch.Emplace(FTopLevelAssetPath(FName(It.Key), FName(FPackageName::GetShortName(It.Key))));
+				break;
+			}
+		}
+	}
+
+	// Sequences are loaded in the background only once the job is close to start, so nothing is kept in memory while it waits in the queue
+	Subsystem->EnqueueJob(TEXT("Watch"), [SoundsToTrim = MoveTemp(SoundsToTrim), SequencesToLoad = MoveTemp(SequencesToLoad)]()
+	{
+		TArray<FAudioTrimmerAssetPlan> AssetPlans;
+		for (const FString& PackageName : SequencesToLoad)
+		{
+			UPackage* Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+			const ULevelSequence* LevelSequence = Package ? Cast<ULevelSequence>(Package->FindAssetInPackage()) : nullptr;
+			if (!LevelSequence)
+			{
+				UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to load level sequence %s. Skipping..."), *PackageName);
+				continue;
+			}
+
+			TArray<UMovieSceneAudioSection*> AudioSections;
+			UAudioTrimmerUtilsLibrary::GetSectionRanges(LevelSequence).GetKeys(AudioSections);
+			AudioSections.RemoveAll([&SoundsToTrim](const UMovieSceneAudioSection* AudioSection)
+			{
+				return !SoundsToTrim.Contains(GetPathNameSafe(AudioSection->GetSound()));
+			});
+
+			UAudioTrimmerUtilsLibrary::AddAudioSectionsToPlans(LevelSequence, AudioSections, AssetPlans);
+		}
+
+		UAudioTrimmerUtilsLibrary::FinalizeAssetPlans(AssetPlans);
+		return AssetPlans;
+	}, {}, SequencesToPrefetch);
+}
+
+// Returns the union of used frames of each given sound wave across all level sequences of the manifest
+TMap<FString, FAudioTrimmerFrameRange> FAudioTrimmerWatcher::GetUsedRanges(const TSet<FString>& SoundWavePaths) const
+{
+	TMap<FString, FAudioTrimmerFrameRange> UsedRanges;
+	for (const TTuple<FString, FAudioTrimmerSequenceUsage>& It : Manifest.GetSequences())
+	{
+		for (const FAudioTrimmerSectionUsage& SectionUsage : It.Value.Sections)
+		{
+			if (!SoundWavePaths.Contains(SectionUsage.SoundWavePath))
+			{
+				continue;
+			}
+
+			if (FAudioTrimmerFrameRange* UsedRange = UsedRanges.Find(SectionUsage.SoundWavePath))
+			{
+				UsedRange->StartFrame = FMath::Min(UsedRange->StartFrame, SectionUsage.FrameRange.StartFrame);
+				UsedRange->EndFrame = FMath::Max(UsedRange->EndFrame, SectionUsage.FrameRange.EndFrame);
+			}
+			else
+			{
+				UsedRanges.Add(SectionUsage.SoundWavePath, SectionUsage.FrameRange);
+			}
+		}
+	}
+	return UsedRanges;
+}
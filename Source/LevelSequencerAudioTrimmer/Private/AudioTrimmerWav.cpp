@@ -0,0 +1,823 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#include "AudioTrimmerWav.h"
+//---
+#include "AudioTrimmerAnalyzer.h"
+#include "AudioTrimmerUtilsLibrary.h"
+//---
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+
+namespace AudioTrimmerWav
+{
+	constexpr uint16 FormatPcm = 0x0001;
+	constexpr uint16 FormatFloat = 0x0003;
+	constexpr uint16 FormatExtensible = 0xFFFE;
+
+	/** Size of the 'ds64' chunk payload without the optional table. */
+	constexpr uint32 Ds64ChunkSize = 28;
+
+	/** Largest 'fmt ' chunk accepted, real ones are at most 40 bytes, so anything bigger is a corrupted file. */
+	constexpr int64 MaxFormatChunkSize = 64 * 1024;
+
+	bool ReadBytes(IFileHandle& FileHandle, void* Dest, int64 Size)
+	{
+		return FileHandle.Read(static_cast<uint8*>(Dest), Size);
+	}
+
+	bool IsChunkId(const uint8* Id, const ANSICHAR* Expected)
+	{
+		return FMemory::Memcmp(Id, Expected, 4) == 0;
+	}
+
+	template <typename T>
+	T ReadLE(const uint8* Src)
+	{
+		T Value;
+		FMemory::Memcpy(&Value, Src, sizeof(T));
+		return Value;
+	}
+
+	template <typename T>
+	void AppendLE(TArray<uint8>& Dest, T Value)
+	{
+		Dest.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+	}
+
+	void AppendId(TArray<uint8>& Dest, const ANSICHAR* Id)
+	{
+		Dest.Append(reinterpret_cast<const uint8*>(Id), 4);
+	}
+
+	/** Returns the format tag, resolving the sub-format of extensible files. */
+	uint16 GetActualFormat(const FAudioTrimmerWavHeader& Header)
+	{
+		// Extensible format keeps the actual format in the first two bytes of the sub-format GUID
+		constexpr int32 SubFormatOffset = 24;
+		if (Header.FormatTag == FormatExtensible && Header.FormatChunk.Num() >= SubFormatOffset + 2)
+		{
+			return ReadLE<uint16>(Header.FormatChunk.GetData() + SubFormatOffset);
+		}
+		return Header.FormatTag;
+	}
+
+	/** Decodes whole frames chunk by chunk and feeds them to the analyzer, so floats of a whole range are never resident at once. */
+	void AnalyzeFrames(FAudioTrimmerAnalyzer& Analyzer, TConstArrayView64<uint8> Bytes, const FAudioTrimmerWavHeader& Header, TArray<float>& SampleBuffer)
+	{
+		const int64 ChunkBytes = FMath::Max<int64>(FAudioTrimmerWav::StreamChunkSize / sizeof(float) / Header.NumChannels, 1) * Header.BlockAlign;
+		for (int64 Offset = 0; Offset < Bytes.Num(); Offset += ChunkBytes)
+		{
+			// A chunk never exceeds the stream chunk size, so it always fits a regular view
+			const int32 NumBytes = static_cast<int32>(FMath::Min(ChunkBytes, Bytes.Num() - Offset));
+			FAudioTrimmerWav::DecodeSamples(TConstArrayView<uint8>(Bytes.GetData() + Offset, NumBytes), Header, SampleBuffer);
+			Analyzer.Process(SampleBuffer);
+		}
+	}
+
+	/** Read-only file handle over bytes in memory, so WAV data that never touched the disk is parsed the same way as files. */
+	class FMemoryFileHandle final : public IFileHandle
+	{
+	public:
+		explicit FMemoryFileHandle(TConstArrayView<uint8> InBytes) : Bytes(InBytes) {}
+
+		virtual int64 Tell() override { return Position; }
+		virtual bool SeekFromEnd(int64 NewPositionRelativeToEnd) override { return Seek(Bytes.Num() + NewPositionRelativeToEnd); }
+		virtual bool Write(const uint8* Source, int64 BytesToWrite) override { return false; }
+		virtual bool Flush(const bool bFullFlush) override { return true; }
+		virtual bool Truncate(int64 NewSize) override { return false; }
+		virtual int64 Size() override { return Bytes.Num(); }
+
+		virtual bool Seek(int64 NewPosition) override
+		{
+			if (NewPosition < 0 || NewPosition > Bytes.Num())
+			{
+				return false;
+			}
+			Position = NewPosition;
+			return true;
+		}
+
+		virtual bool Read(uint8* Destination, int64 BytesToRead) override
+		{
+			if (BytesToRead < 0 || Position + BytesToRead > Bytes.Num())
+			{
+				return false;
+			}
+			FMemory::Memcpy(Destination, Bytes.GetData() + Position, BytesToRead);
+			Position += BytesToRead;
+			return true;
+		}
+
+	private:
+		TConstArrayView<uint8> Bytes;
+		int64 Position = 0;
+	};
+}
+
+// Returns true if samples are uncompressed, so the data chunk can be sliced by frames
+bool FAudioTrimmerWavHeader::IsUncompressed() const
+{
+	using namespace AudioTrimmerWav;
+
+	if (BlockAlign == 0 || NumChannels == 0)
+	{
+		return false;
+	}
+
+	const uint16 Format = GetActualFormat(*this);
+	return Format == FormatPcm || Format == FormatFloat;
+}
+
+// Returns true if samples are stored as IEEE floats
+bool FAudioTrimmerWavHeader::IsFloat() const
+{
+	return AudioTrimmerWav::GetActualFormat(*this) == AudioTrimmerWav::FormatFloat;
+}
+
+// Creates the header of a plain PCM or IEEE float WAV file with the given format
+FAudioTrimmerWavHeader FAudioTrimmerWavHeader::Make(uint16 InNumChannels, uint32 InSampleRate, uint16 InBitsPerSample, bool bInFloat)
+{
+	using namespace AudioTrimmerWav;
+
+	FAudioTrimmerWavHeader Header;
+	Header.FormatTag = bInFloat ? FormatFloat : FormatPcm;
+	Header.NumChannels = InNumChannels;
+	Header.SampleRate = InSampleRate;
+	Header.BitsPerSample = InBitsPerSample;
+	Header.BlockAlign = InNumChannels * (InBitsPerSample / 8);
+
+	// Format tag, channels, sample rate, byte rate, block align, bits per sample, and extra size for non-PCM formats
+	AppendLE<uint16>(Header.FormatChunk, Header.FormatTag);
+	AppendLE<uint16>(Header.FormatChunk, Header.NumChannels);
+	AppendLE<uint32>(Header.FormatChunk, Header.SampleRate);
+	AppendLE<uint32>(Header.FormatChunk, Header.SampleRate * Header.BlockAlign);
+	AppendLE<uint16>(Header.FormatChunk, Header.BlockAlign);
+	AppendLE<uint16>(Header.FormatChunk, Header.BitsPerSample);
+	if (bInFloat)
+	{
+		AppendLE<uint16>(Header.FormatChunk, 0);
+	}
+
+	return Header;
+}
+
+// Releases the mapping on destruction
+FAudioTrimmerMappedWav::~FAudioTrimmerMappedWav()
+{
+	Close();
+}
+
+// Maps the data chunk of the given WAV file
+bool FAudioTrimmerMappedWav::Open(const FString& FilePath)
+{
+	Close();
+
+	if (!FAudioTrimmerWav::ReadHeader(FilePath, Header)
+		|| !Header.IsUncompressed()
+		|| Header.DataSize <= 0)
+	{
+		return false;
+	}
+
+	MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	if (!MappedHandle)
+	{
+		return false;
+	}
+
+	MappedRegion.Reset(MappedHandle->MapRegion(Header.DataOffset, Header.DataSize));
+	if (!MappedRegion)
+	{
+		MappedHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+// Releases the mapping
+void FAudioTrimmerMappedWav::Close()
+{
+	// Region has to be released before its file handle
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+}
+
+// Returns the bytes of the given frame range, clamped to the file length
+TConstArrayView64<uint8> FAudioTrimmerMappedWav::GetFrames(const FAudioTrimmerFrameRange& FrameRange) const
+{
+	if (!MappedRegion)
+	{
+		return {};
+	}
+
+	const int64 TotalFrames = FMath::Min<int64>(Header.GetNumFrames(), MappedRegion->GetMappedSize() / Header.BlockAlign);
+	const int64 StartFrame = FMath::Clamp<int64>(FrameRange.StartFrame, 0, TotalFrames);
+	const int64 EndFrame = FMath::Clamp<int64>(FrameRange.EndFrame, StartFrame, TotalFrames);
+	return TConstArrayView64<uint8>(MappedRegion->GetMappedPtr() + StartFrame * Header.BlockAlign, (EndFrame - StartFrame) * Header.BlockAlign);
+}
+
+// Parses the header of the given WAV file
+bool FAudioTrimmerWav::ReadHeader(IFileHandle& FileHandle, FAudioTrimmerWavHeader& OutHeader)
+{
+	using namespace AudioTrimmerWav;
+
+	OutHeader = FAudioTrimmerWavHeader();
+
+	uint8 RiffHeader[12];
+	if (!FileHandle.Seek(0) || !ReadBytes(FileHandle, RiffHeader, sizeof(RiffHeader)))
+	{
+		return false;
+	}
+
+	const bool bIsRF64 = IsChunkId(RiffHeader, "RF64") || IsChunkId(RiffHeader, "BW64");
+	if ((!bIsRF64 && !IsChunkId(RiffHeader, "RIFF"))
+		|| !IsChunkId(RiffHeader + 8, "WAVE"))
+	{
+		return false;
+	}
+
+	const int64 FileSize = FileHandle.Size();
+	int64 Ds64DataSize = INDEX_NONE;
+	bool bFoundFormat = false;
+
+	int64 ChunkOffset = sizeof(RiffHeader);
+	while (ChunkOffset + 8 <= FileSize)
+	{
+		uint8 ChunkHeader[8];
+		if (!FileHandle.Seek(ChunkOffset) || !ReadBytes(FileHandle, ChunkHeader, sizeof(ChunkHeader)))
+		{
+			return false;
+		}
+
+		const int64 ChunkSize = ReadLE<uint32>(ChunkHeader + 4);
+		const int64 PayloadOffset = ChunkOffset + sizeof(ChunkHeader);
+
+		if (IsChunkId(ChunkHeader, "ds64"))
+		{
+			uint8 Ds64[Ds64ChunkSize];
+			if (ChunkSize < Ds64ChunkSize || !ReadBytes(FileHandle, Ds64, sizeof(Ds64)))
+			{
+				return false;
+			}
+			// RIFF size (8), data size (8), sample count (8), table length (4)
+			Ds64DataSize = ReadLE<uint64>(Ds64 + 8);
+		}
+		else if (IsChunkId(ChunkHeader, "fmt "))
+		{
+			// The chunk is copied as is, so its size is checked before anything is allocated
+			if (ChunkSize < 16
+				|| ChunkSize > MaxFormatChunkSize
+				|| ChunkSize > FileSize - PayloadOffset)
+			{
+				return false;
+			}
+
+			OutHeader.FormatChunk.SetNumUninitialized(ChunkSize);
+			if (!ReadBytes(FileHandle, OutHeader.FormatChunk.GetData(), ChunkSize))
+			{
+				return false;
+			}
+
+			const uint8* Fmt = OutHeader.FormatChunk.GetData();
+			OutHeader.FormatTag = ReadLE<uint16>(Fmt + 0);
+			OutHeader.NumChannels = ReadLE<uint16>(Fmt + 2);
+			OutHeader.SampleRate = ReadLE<uint32>(Fmt + 4);
+			OutHeader.BlockAlign = ReadLE<uint16>(Fmt + 12);
+			OutHeader.BitsPerSample = ReadLE<uint16>(Fmt + 14);
+			bFoundFormat = true;
+		}
+		else if (IsChunkId(ChunkHeader, "data"))
+		{
+			OutHeader.DataOffset = PayloadOffset;
+			OutHeader.DataSize = bIsRF64 && ChunkSize == MAX_uint32 && Ds64DataSize != INDEX_NONE ? Ds64DataSize : ChunkSize;
+
+			// Tolerate truncated files and streamed headers that could not be patched
+			OutHeader.DataSize = FMath::Min(OutHeader.DataSize, FileSize - PayloadOffset);
+			return bFoundFormat;
+		}
+
+		// Chunks are word-aligned
+		ChunkOffset = PayloadOffset + ChunkSize + (ChunkSize & 1);
+	}
+
+	return false;
+}
+
+// Parses the header of the WAV file at the given path
+bool FAudioTrimmerWav::ReadHeader(const FString& FilePath, FAudioTrimmerWavHeader& OutHeader)
+{
+	const TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath));
+	return FileHandle && ReadHeader(*FileHandle, OutHeader);
+}
+
+// Parses the header of WAV data in memory
+bool FAudioTrimmerWav::ReadHeader(TConstArrayView<uint8> WavBytes, FAudioTrimmerWavHeader& OutHeader)
+{
+	AudioTrimmerWav::FMemoryFileHandle FileHandle(WavBytes);
+	return ReadHeader(FileHandle, OutHeader);
+}
+
+// Replaces the placeholder sizes written by encoders that stream to a pipe with the actual sizes
+bool FAudioTrimmerWav::PatchStreamedSizes(TArray<uint8>& InOutWavBytes)
+{
+	using namespace AudioTrimmerWav;
+
+	uint8* Bytes = InOutWavBytes.GetData();
+	const int64 NumBytes = InOutWavBytes.Num();
+	if (NumBytes < 12
+		|| !IsChunkId(Bytes, "RIFF")
+		|| !IsChunkId(Bytes + 8, "WAVE"))
+	{
+		return false;
+	}
+
+	const uint32 RiffSize = static_cast<uint32>(NumBytes - 8);
+	FMemory::Memcpy(Bytes + 4, &RiffSize, sizeof(RiffSize));
+
+	int64 ChunkOffset = 12;
+	while (ChunkOffset + 8 <= NumBytes)
+	{
+		const int64 ChunkSize = ReadLE<uint32>(Bytes + ChunkOffset + 4);
+		const int64 PayloadOffset = ChunkOffset + 8;
+		if (IsChunkId(Bytes + ChunkOffset, "data"))
+		{
+			// Data is the last chunk of a streamed file, so it takes everything that was written
+			const uint32 DataSize = static_cast<uint32>(FMath::Min(ChunkSize, NumBytes - PayloadOffset));
+			FMemory::Memcpy(Bytes + ChunkOffset + 4, &DataSize, sizeof(DataSize));
+			return true;
+		}
+
+		ChunkOffset = PayloadOffset + ChunkSize + (ChunkSize & 1);
+	}
+
+	return false;
+}
+
+// Writes a WAV header for the given format followed by the empty data chunk header
+bool FAudioTrimmerWav::WriteHeader(IFileHandle& FileHandle, const FAudioTrimmerWavHeader& Header, int64 DataSize, bool bForceRF64)
+{
+	using namespace AudioTrimmerWav;
+
+	const bool bNeedsRF64 = bForceRF64 || DataSize > MaxRiffDataSize;
+	const uint32 FormatChunkSize = Header.FormatChunk.Num();
+	const uint32 FormatPadding = FormatChunkSize & 1;
+	const uint32 DataPadding = DataSize & 1;
+
+	// 'WAVE' + optional 'ds64' chunk + 'fmt ' chunk + 'data' chunk header
+	const int64 Ds64Total = bNeedsRF64 ? 8 + Ds64ChunkSize : 0;
+	const int64 RiffSize = 4 + Ds64Total + 8 + FormatChunkSize + FormatPadding + 8 + DataSize + DataPadding;
+
+	TArray<uint8> Bytes;
+	Bytes.Reserve(12 + Ds64Total + 8 + FormatChunkSize + FormatPadding + 8);
+
+	AppendId(Bytes, bNeedsRF64 ? "RF64" : "RIFF");
+	AppendLE<uint32>(Bytes, bNeedsRF64 ? MAX_uint32 : static_cast<uint32>(RiffSize));
+	AppendId(Bytes, "WAVE");
+
+	if (bNeedsRF64)
+	{
+		AppendId(Bytes, "ds64");
+		AppendLE<uint32>(Bytes, Ds64ChunkSize);
+		AppendLE<uint64>(Bytes, RiffSize);
+		AppendLE<uint64>(Bytes, DataSize);
+		AppendLE<uint64>(Bytes, Header.BlockAlign > 0 ? DataSize / Header.BlockAlign : 0);
+		AppendLE<uint32>(Bytes, 0);
+	}
+
+	AppendId(Bytes, "fmt ");
+	AppendLE<uint32>(Bytes, FormatChunkSize);
+	Bytes.Append(Header.FormatChunk);
+	if (FormatPadding)
+	{
+		Bytes.Add(0);
+	}
+
+	AppendId(Bytes, "data");
+	AppendLE<uint32>(Bytes, bNeedsRF64 ? MAX_uint32 : static_cast<uint32>(DataSize));
+
+	return FileHandle.Write(Bytes.GetData(), Bytes.Num());
+}
+
+// Copies the given frame ranges of the input WAV file into a new WAV file, one after another
+bool FAudioTrimmerWav::CopyFrameRanges(const FString& InputPath, const FString& OutputPath, const TArray<FAudioTrimmerFrameRange>& FrameRanges, FAudioTrimmerAnalyzer* Analyzer)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	const TUniquePtr<IFileHandle> InputHandle(PlatformFile.OpenRead(*InputPath));
+	FAudioTrimmerWavHeader Header;
+	if (!InputHandle || !ReadHeader(*InputHandle, Header))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to read WAV header: %s"), *InputPath);
+		return false;
+	}
+
+	if (!Header.IsUncompressed())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("WAV file is not uncompressed PCM, format tag: %u, file: %s"), Header.FormatTag, *InputPath);
+		return false;
+	}
+
+	// Clamp ranges to the actual length of the input
+	const int64 TotalFrames = Header.GetNumFrames();
+	TArray<FAudioTrimmerFrameRange> ClampedRanges;
+	ClampedRanges.Reserve(FrameRanges.Num());
+	int64 OutputDataSize = 0;
+	for (const FAudioTrimmerFrameRange& Range : FrameRanges)
+	{
+		const FAudioTrimmerFrameRange Clamped(FMath::Clamp<int64>(Range.StartFrame, 0, TotalFrames), FMath::Clamp<int64>(Range.EndFrame, 0, TotalFrames));
+		if (!Clamped.IsEmpty())
+		{
+			ClampedRanges.Add(Clamped);
+			OutputDataSize += Clamped.Num() * Header.BlockAlign;
+		}
+	}
+
+	if (OutputDataSize == 0)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Nothing to copy, all frame ranges are empty for: %s"), *InputPath);
+		return false;
+	}
+
+	const TUniquePtr<IFileHandle> OutputHandle(PlatformFile.OpenWrite(*OutputPath));
+	if (!OutputHandle || !WriteHeader(*OutputHandle, Header, OutputDataSize))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to write WAV header: %s"), *OutputPath);
+		return false;
+	}
+
+	// Copied samples are analyzed in the same pass while they are still in memory
+	TArray<float> SampleBuffer;
+
+	// Writes are aligned to whole frames and never exceed the stream chunk size
+	const int64 FramesPerChunk = FMath::Max<int64>(StreamChunkSize / Header.BlockAlign, 1);
+
+	// Preferably write samples directly from the mapped input pages
+	FAudioTrimmerMappedWav MappedInput;
+	if (MappedInput.Open(InputPath))
+	{
+		const int64 ChunkBytes = FramesPerChunk * Header.BlockAlign;
+		for (const FAudioTrimmerFrameRange& Range : ClampedRanges)
+		{
+			const TConstArrayView64<uint8> Frames = MappedInput.GetFrames(Range);
+			for (int64 Offset = 0; Offset < Frames.Num(); Offset += ChunkBytes)
+			{
+				const TConstArrayView64<uint8> Slice = Frames.Slice(Offset, FMath::Min(ChunkBytes, Frames.Num() - Offset));
+				if (!OutputHandle->Write(Slice.GetData(), Slice.Num()))
+				{
+					UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to write mapped samples from %s to %s"), *InputPath, *OutputPath);
+					return false;
+				}
+
+				if (Analyzer)
+				{
+					AnalyzeFrames(*Analyzer, Slice, Header, SampleBuffer);
+				}
+			}
+		}
+	}
+	else
+	{
+		TArray<uint8> Buffer;
+		Buffer.SetNumUninitialized(FMath::Min(FramesPerChunk * Header.BlockAlign, OutputDataSize));
+
+		for (const FAudioTrimmerFrameRange& Range : ClampedRanges)
+		{
+			if (!InputHandle->Seek(Header.DataOffset + Range.StartFrame * Header.BlockAlign))
+			{
+				return false;
+			}
+
+			int64 RemainingBytes = Range.Num() * Header.BlockAlign;
+			while (RemainingBytes > 0)
+			{
+				const int64 BytesToCopy = FMath::Min<int64>(RemainingBytes, Buffer.Num());
+				if (!InputHandle->Read(Buffer.GetData(), BytesToCopy)
+					|| !OutputHandle->Write(Buffer.GetData(), BytesToCopy))
+				{
+					UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to stream samples from %s to %s"), *InputPath, *OutputPath);
+					return false;
+				}
+
+				if (Analyzer)
+				{
+					AnalyzeFrames(*Analyzer, TConstArrayView64<uint8>(Buffer.GetData(), BytesToCopy), Header, SampleBuffer);
+				}
+				RemainingBytes -= BytesToCopy;
+			}
+		}
+	}
+
+	if (OutputDataSize & 1)
+	{
+		constexpr uint8 PadByte = 0;
+		OutputHandle->Write(&PadByte, 1);
+	}
+
+	return OutputHandle->Flush();
+}
+
+// Converts raw samples of the given format into floats in the [-1, 1] range
+void FAudioTrimmerWav::DecodeSamples(TConstArrayView<uint8> Bytes, const FAudioTrimmerWavHeader& Header, TArray<float>& OutSamples)
+{
+	const int32 BytesPerSample = Header.GetBytesPerSample();
+	const int64 NumSamples = BytesPerSample > 0 ? Bytes.Num() / BytesPerSample : 0;
+	OutSamples.SetNumUninitialized(NumSamples);
+
+	const uint8* Src = Bytes.GetData();
+	float* Dest = OutSamples.GetData();
+
+	if (Header.IsFloat())
+	{
+		if (BytesPerSample == sizeof(float))
+		{
+			FMemory::Memcpy(Dest, Src, NumSamples * sizeof(float));
+		}
+		else
+		{
+			for (int64 Index = 0; Index < NumSamples; ++Index)
+			{
+				Dest[Index] = static_cast<float>(AudioTrimmerWav::ReadLE<double>(Src + Index * sizeof(double)));
+			}
+		}
+		return;
+	}
+
+	switch (BytesPerSample)
+	{
+	case 1:
+		for (int64 Index = 0; Index < NumSamples; ++Index)
+		{
+			Dest[Index] = (static_cast<int32>(Src[Index]) - 128) / 128.0f;
+		}
+		break;
+	case 2:
+		for (int64 Index = 0; Index < NumSamples; ++Index)
+		{
+			Dest[Index] = AudioTrimmerWav::ReadLE<int16>(Src + Index * 2) / 32768.0f;
+		}
+		break;
+	case 3:
+		for (int64 Index = 0; Index < NumSamples; ++Index)
+		{
+			const uint8* Sample = Src + Index * 3;
+			// Shift up to the sign bit of int32 and back to extend the sign
+			const int32 Value = static_cast<int32>(static_cast<uint32>(Sample[0]) << 8 | static_cast<uint32>(Sample[1]) << 16 | static_cast<uint32>(Sample[2]) << 24) >> 8;
+			Dest[Index] = Value / 8388608.0f;
+		}
+		break;
+	case 4:
+		for (int64 Index = 0; Index < NumSamples; ++Index)
+		{
+			Dest[Index] = static_cast<float>(AudioTrimmerWav::ReadLE<int32>(Src + Index * 4) / 2147483648.0);
+		}
+		break;
+	default:
+		FMemory::Memzero(Dest, NumSamples * sizeof(float));
+		break;
+	}
+}
+
+// Converts floats in the [-1, 1] range into raw samples of the given format, appending them to the output
+void FAudioTrimmerWav::EncodeSamples(TConstArrayView<float> Samples, const FAudioTrimmerWavHeader& Header, TArray<uint8>& OutBytes)
+{
+	const int32 BytesPerSample = Header.GetBytesPerSample();
+	const int64 StartIndex = OutBytes.Num();
+	OutBytes.AddUninitialized(Samples.Num() * BytesPerSample);
+	uint8* Dest = OutBytes.GetData() + StartIndex;
+
+	if (Header.IsFloat())
+	{
+		if (BytesPerSample == sizeof(float))
+		{
+			FMemory::Memcpy(Dest, Samples.GetData(), Samples.Num() * sizeof(float));
+		}
+		else
+		{
+			for (int64 Index = 0; Index < Samples.Num(); ++Index)
+			{
+				const double Value = Samples[Index];
+				FMemory::Memcpy(Dest + Index * sizeof(double), &Value, sizeof(double));
+			}
+		}
+		return;
+	}
+
+	for (int64 Index = 0; Index < Samples.Num(); ++Index)
+	{
+		const float Sample = FMath::Clamp(Samples[Index], -1.0f, 1.0f);
+		uint8* Out = Dest + Index * BytesPerSample;
+		switch (BytesPerSample)
+		{
+		case 1:
+			Out[0] = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt32(Sample * 128.0f) + 128, 0, 255));
+			break;
+		case 2:
+		{
+			const int16 Value = static_cast<int16>(FMath::Clamp(FMath::RoundToInt32(Sample * 32768.0f), -32768, 32767));
+			FMemory::Memcpy(Out, &Value, sizeof(Value));
+			break;
+		}
+		case 3:
+		{
+			const int32 Value = FMath::Clamp(FMath::RoundToInt32(Sample * 8388608.0f), -8388608, 8388607);
+			Out[0] = static_cast<uint8>(Value);
+			Out[1] = static_cast<uint8>(Value >> 8);
+			Out[2] = static_cast<uint8>(Value >> 16);
+			break;
+		}
+		case 4:
+		{
+			const int32 Value = static_cast<int32>(FMath::Clamp<double>(FMath::RoundToDouble(Sample * 2147483648.0), MIN_int32, MAX_int32));
+			FMemory::Memcpy(Out, &Value, sizeof(Value));
+			break;
+		}
+		default:
+			FMemory::Memzero(Out, BytesPerSample);
+			break;
+		}
+	}
+}
+
+// Reads and decodes a small range of frames of the given WAV file
+FAudioTrimmerFrameRange FAudioTrimmerWav::ReadFrames(const FString& FilePath, const FAudioTrimmerWavHeader& Header, const FAudioTrimmerFrameRange& FrameRange, TArray<float>& OutSamples)
+{
+	OutSamples.Reset();
+
+	const int64 TotalFrames = Header.GetNumFrames();
+	const FAudioTrimmerFrameRange Range(FMath::Clamp<int64>(FrameRange.StartFrame, 0, TotalFrames), FMath::Clamp<int64>(FrameRange.EndFrame, 0, TotalFrames));
+	const TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath));
+	if (Range.IsEmpty() || !FileHandle)
+	{
+		return {};
+	}
+
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized(Range.Num() * Header.BlockAlign);
+	if (!FileHandle->Seek(Header.DataOffset + Range.StartFrame * Header.BlockAlign)
+		|| !FileHandle->Read(Bytes.GetData(), Bytes.Num()))
+	{
+		return {};
+	}
+
+	DecodeSamples(Bytes, Header, OutSamples);
+	return Range;
+}
+
+// Decodes, modifies and writes back a range of frames of the given WAV file in place
+bool FAudioTrimmerWav::ModifyFrames(const FString& FilePath, const FAudioTrimmerFrameRange& FrameRange, TFunctionRef<void(TArrayView<float> InterleavedSamples, int64 StartFrame)> Modifier)
+{
+	FAudioTrimmerWavHeader Header;
+	if (!ReadHeader(FilePath, Header)
+		|| !Header.IsUncompressed())
+	{
+		return false;
+	}
+
+	TArray<float> Samples;
+	const FAudioTrimmerFrameRange Range = ReadFrames(FilePath, Header, FrameRange, Samples);
+	if (Range.IsEmpty())
+	{
+		return false;
+	}
+
+	Modifier(Samples, Range.StartFrame);
+
+	TArray<uint8> Bytes;
+	EncodeSamples(Samples, Header, Bytes);
+
+	const TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath, /*bAppend*/true, /*bAllowRead*/true));
+	return FileHandle
+		&& FileHandle->Seek(Header.DataOffset + Range.StartFrame * Header.BlockAlign)
+		&& FileHandle->Write(Bytes.GetData(), Bytes.Num())
+		&& FileHandle->Flush();
+}
+
+// Decodes all samples of the given WAV file chunk by chunk
+bool FAudioTrimmerWav::ForEachSampleChunk(const FString& InputPath, FAudioTrimmerWavHeader& OutHeader, TFunctionRef<bool(TConstArrayView<float> InterleavedSamples)> Visitor)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const TUniquePtr<IFileHandle> InputHandle(PlatformFile.OpenRead(*InputPath));
+	if (!InputHandle
+		|| !ReadHeader(*InputHandle, OutHeader)
+		|| !OutHeader.IsUncompressed())
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to read uncompressed WAV file: %s"), *InputPath);
+		return false;
+	}
+
+	// Decoded floats of one chunk never exceed the stream chunk size
+	const int64 TotalFrames = OutHeader.GetNumFrames();
+	const int64 FramesPerChunk = FMath::Max<int64>(StreamChunkSize / (OutHeader.NumChannels * sizeof(float)), 1);
+
+	FAudioTrimmerMappedWav MappedInput;
+	const bool bMapped = MappedInput.Open(InputPath);
+
+	TArray<uint8> ReadBuffer;
+	TArray<float> Samples;
+
+	for (int64 StartFrame = 0; StartFrame < TotalFrames; StartFrame += FramesPerChunk)
+	{
+		const FAudioTrimmerFrameRange Range(StartFrame, FMath::Min(StartFrame + FramesPerChunk, TotalFrames));
+
+		TConstArrayView<uint8> Bytes;
+		if (bMapped)
+		{
+			// A chunk never exceeds the stream chunk size, so it always fits a regular view
+			const TConstArrayView64<uint8> MappedBytes = MappedInput.GetFrames(Range);
+			Bytes = TConstArrayView<uint8>(MappedBytes.GetData(), static_cast<int32>(MappedBytes.Num()));
+		}
+		else
+		{
+			ReadBuffer.SetNumUninitialized(Range.Num() * OutHeader.BlockAlign, EAllowShrinking::No);
+			if (!InputHandle->Seek(OutHeader.DataOffset + Range.StartFrame * OutHeader.BlockAlign)
+				|| !InputHandle->Read(ReadBuffer.GetData(), ReadBuffer.Num()))
+			{
+				return false;
+			}
+			Bytes = ReadBuffer;
+		}
+
+		DecodeSamples(Bytes, OutHeader, Samples);
+		if (!Visitor(Samples))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Closes the file if it is still open
+FAudioTrimmerWavWriter::~FAudioTrimmerWavWriter()
+{
+	if (FileHandle)
+	{
+		Close();
+	}
+}
+
+// Creates the file and writes its header
+bool FAudioTrimmerWavWriter::Open(const FString& FilePath, const FAudioTrimmerWavHeader& InHeader, int64 ExpectedNumFrames)
+{
+	Header = InHeader;
+	DataSize = 0;
+	bFailed = false;
+	bRF64 = ExpectedNumFrames * Header.BlockAlign > FAudioTrimmerWav::MaxRiffDataSize;
+
+	FileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath));
+	if (!FileHandle || !FAudioTrimmerWav::WriteHeader(*FileHandle, Header, 0, bRF64))
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("Failed to create WAV file: %s"), *FilePath);
+		FileHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+// Encodes and appends interleaved samples to the file
+bool FAudioTrimmerWavWriter::Write(TConstArrayView<float> InterleavedSamples)
+{
+	if (!FileHandle || bFailed)
+	{
+		return false;
+	}
+
+	EncodeBuffer.Reset();
+	FAudioTrimmerWav::EncodeSamples(InterleavedSamples, Header, EncodeBuffer);
+	bFailed = !FileHandle->Write(EncodeBuffer.GetData(), EncodeBuffer.Num());
+	DataSize += EncodeBuffer.Num();
+	return !bFailed;
+}
+
+// Patches the header with the actual data size and closes the file
+bool FAudioTrimmerWavWriter::Close()
+{
+	if (!FileHandle)
+	{
+		return false;
+	}
+
+	if (DataSize & 1)
+	{
+		constexpr uint8 PadByte = 0;
+		FileHandle->Write(&PadByte, 1);
+	}
+
+	// Header size must not change, so RIFF header can't grow into RF64 after the samples are written
+	if (!bRF64 && DataSize > FAudioTrimmerWav::MaxRiffDataSize)
+	{
+		UE_LOG(LogAudioTrimmer, Warning, TEXT("WAV data outgrew its RIFF header, expected size was underestimated."));
+		bFailed = true;
+	}
+
+	bFailed = bFailed
+		|| !FileHandle->Seek(0)
+		|| !FAudioTrimmerWav::WriteHeader(*FileHandle, Header, DataSize, bRF64)
+		|| !FileHandle->Flush();
+
+	FileHandle.Reset();
+	return !bFailed;
+}
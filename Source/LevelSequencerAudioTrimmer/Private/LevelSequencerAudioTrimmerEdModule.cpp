@@ -2,13 +2,20 @@
 
 #include "LevelSequencerAudioTrimmerEdModule.h"
 //---
+#include "AudioTrimmerCook.h"
+#include "AudioTrimmerSubsystem.h"
 #include "AudioTrimmerUtilsLibrary.h"
+#include "AudioTrimmerWatcher.h"
 //---
 #include "Editor.h"
+#include "ISequencer.h"
 #include "LevelSequence.h"
+#include "SequencerToolMenuContext.h"
 #include "ToolMenus.h"
 #include "Interfaces/IPluginManager.h"
+#include "Misc/CoreDelegates.h"
 #include "Modules/ModuleManager.h"
+#include "Sections/MovieSceneAudioSection.h"
 
 IMPLEMENT_MODULE(FLevelSequencerAudioTrimmerEdModule, LevelSequencerAudioTrimmer)
 
@@ -25,6 +32,9 @@ void FLevelSequencerAudioTrimmerEdModule::StartupModule()
 
 	InitPluginPath();
 	InitFfmpegPath();
+
+	FCoreDelegates::OnPostEngineInit.AddRaw(this, &FLevelSequencerAudioTrimmerEdModule::StartCookTrimmer);
+	FCoreDelegates::OnPostEngineInit.AddRaw(this, &FLevelSequencerAudioTrimmerEdModule::StartWatcher);
 }
 
 // Called before the module is unloaded, right before the module object is destroyed
@@ -32,6 +42,19 @@ void FLevelSequencerAudioTrimmerEdModule::ShutdownModule()
 {
 	UToolMenus::UnRegisterStartupCallback(this);
 	UToolMenus::UnregisterOwner(this);
+
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+	if (CookTrimmer)
+	{
+		CookTrimmer->Stop();
+		CookTrimmer.Reset();
+	}
+
+	if (Watcher)
+	{
+		Watcher->Stop();
+		Watcher.Reset();
+	}
 }
 
 // Registers the custom context menu item for Level Sequence assets
@@ -49,6 +72,19 @@ void FLevelSequencerAudioTrimmerEdModule::RegisterMenus()
 		FSlateIcon(),
 		FUIAction(FExecuteAction::CreateRaw(this, &FLevelSequencerAudioTrimmerEdModule::OnLevelSequencerAudioTrimmerClicked))
 	);
+
+	// Extend the toolbar of the Sequencer editor to trim only the selected sections
+	UToolMenu* SequencerToolBar = UToolMenus::Get()->ExtendMenu("Sequencer.MainToolBar");
+	FToolMenuSection& SequencerSection = SequencerToolBar->FindOrAddSection("LevelSequencerAudioTrimmer");
+	FToolUIAction TrimSelectedAction;
+	TrimSelectedAction.ExecuteAction = FToolMenuExecuteAction::CreateRaw(this, &FLevelSequencerAudioTrimmerEdModule::OnTrimSelectedSectionsClicked);
+	SequencerSection.AddEntry(FToolMenuEntry::InitToolBarButton(
+		"TrimSelectedAudioSections",
+		TrimSelectedAction,
+		NSLOCTEXT("LevelSequencerAudioTrimmer", "TrimSelectedAudioSections_Label", "Trim Selected Audio"),
+		NSLOCTEXT("LevelSequencerAudioTrimmer", "TrimSelectedAudioSections_Tooltip", "Trims only the sounds of the selected audio sections"),
+		FSlateIcon(FAppStyle::GetAppStyleSetName(), "GenericCommands.Cut")
+	));
 }
 
 // Is called when Audio Trimmer button in clicked in the context menu of the Level Sequence asset
@@ -58,13 +94,59 @@ void FLevelSequencerAudioTrimmerEdModule::OnLevelSequencerAudioTrimmerClicked()
 	TArray<FAssetData> SelectedAssets;
 	GEditor->GetContentBrowserSelections(SelectedAssets);
 
+	UAudioTrimmerSubsystem* Subsystem = UAudioTrimmerSubsystem::Get();
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	// Sequences are queued by path, so the next ones are loaded in the background while the current one is trimmed
+	TArray<TWeakObjectPtr<UAudioTrimmerJob>> Jobs;
 	for (const FAssetData& AssetData : SelectedAssets)
 	{
-		if (const ULevelSequence* LevelSequenceIt = Cast<ULevelSequence>(AssetData.GetAsset()))
+		if (AssetData.IsInstanceOf<ULevelSequence>())
+		{
+			Jobs.Add(Subsystem->EnqueueLevelSequencePath(AssetData.GetSoftObjectPath()));
+		}
+	}
+
+	// Only the selected sequences are run, jobs queued by others keep waiting for their turn
+	for (const TWeakObjectPtr<UAudioTrimmerJob>& Job : Jobs)
+	{
+		Subsystem->RunJob(Job.Get());
+	}
+}
+
+// Is called when the Trim Selected Audio button is clicked in the Sequencer toolbar
+void FLevelSequencerAudioTrimmerEdModule::OnTrimSelectedSectionsClicked(const FToolMenuContext& Context)
+{
+	const USequencerToolMenuContext* SequencerContext = Context.FindContext<USequencerToolMenuContext>();
+	const TSharedPtr<ISequencer> Sequencer = SequencerContext ? SequencerContext->WeakSequencer.Pin() : nullptr;
+	if (!Sequencer)
+	{
+		return;
+	}
+
+	TArray<UMovieSceneSection*> SelectedSections;
+	Sequencer->GetSelectedSections(SelectedSections);
+
+	// Selected sections might come from different sub-sequences, each is trimmed within its own level sequence
+	TMap<ULevelSequence*, TArray<UMovieSceneAudioSection*>> AudioSectionsBySequence;
+	for (UMovieSceneSection* Section : SelectedSections)
+	{
+		UMovieSceneAudioSection* AudioSection = Cast<UMovieSceneAudioSection>(Section);
+		if (ULevelSequence* LevelSequence = AudioSection ? AudioSection->GetTypedOuter<ULevelSequence>() : nullptr)
 		{
-			UAudioTrimmerUtilsLibrary::RunLevelSequenceAudioTrimmer(LevelSequenceIt);
+			AudioSectionsBySequence.FindOrAdd(LevelSequence).Add(AudioSection);
 		}
 	}
+
+	for (const TTuple<ULevelSequence*, TArray<UMovieSceneAudioSection*>>& It : AudioSectionsBySequence)
+	{
+		UAudioTrimmerUtilsLibrary::RunAudioSectionsTrimmer(It.Key, It.Value);
+	}
+
+	Sequencer->NotifyMovieSceneDataChanged(EMovieSceneDataChangeType::TrackValueChanged);
 }
 
 /*********************************************************************************************
@@ -104,3 +186,35 @@ void FLevelSequencerAudioTrimmerEdModule::InitFfmpegPath()
 	// Convert the relative path to an absolute path
 	FfmpegPath = FPaths::ConvertRelativePathToFull(RelativePath);
 }
+
+/*********************************************************************************************
+ * Cook-time trimming
+ ********************************************************************************************* */
+
+// Starts trimming sound waves in memory if this process is a cook and it is enabled in the settings
+void FLevelSequencerAudioTrimmerEdModule::StartCookTrimmer()
+{
+	if (!FAudioTrimmerCookTrimmer::ShouldTrimAtCookTime())
+	{
+		return;
+	}
+
+	CookTrimmer = MakeShared<FAudioTrimmerCookTrimmer>();
+	CookTrimmer->Start();
+}
+
+/*********************************************************************************************
+ * Watch mode
+ ********************************************************************************************* */
+
+// Starts trimming sound waves of saved level sequences if it is enabled in the settings
+void FLevelSequencerAudioTrimmerEdModule::StartWatcher()
+{
+	if (!FAudioTrimmerWatcher::ShouldWatch())
+	{
+		return;
+	}
+
+	Watcher = MakeShared<FAudioTrimmerWatcher>();
+	Watcher->Start();
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Level statistics of trimmed audio, written to the run report and to the metadata of the sound wave.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerAudioStats
+{
+	/** Level reported for digital silence, so every value stays finite in JSON. */
+	static constexpr float MinDecibels = -144.f;
+
+	/** True if the statistics were computed, false if the audio was not analyzed. */
+	bool bIsValid = false;
+
+	/** Largest absolute sample of all channels in dBFS. */
+	float PeakDbfs = MinDecibels;
+
+	/** Root mean square of all samples of all channels in dBFS. */
+	float RmsDbfs = MinDecibels;
+
+	/** Gated integrated loudness in LUFS as defined by EBU R128 and ITU-R BS.1770. */
+	float IntegratedLufs = MinDecibels;
+
+	/** Part of the frames where every channel is below the silence threshold, in the [0, 100] range. */
+	float SilencePercent = 0.f;
+};
+
+/**
+ * Streaming analyzer of interleaved float audio that computes all statistics in a single pass.
+ * Peak and RMS are accumulated in SIMD registers, loudness runs the K-weighting filter per channel
+ * and keeps only one mean square per 100 ms, so memory usage does not depend on the audio length.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerAnalyzer
+{
+public:
+	/** Prepares the filters for the given format.
+	 * @param InNumChannels Number of interleaved channels, channel weights follow the 5.1 layout when there are six or more.
+	 * @param InSampleRate Sample rate the K-weighting filter is designed for.
+	 * @param SilenceThresholdDb Frames where every channel is quieter than this are counted as silent.
+	 * @return True if the format is supported. */
+	bool Init(int32 InNumChannels, uint32 InSampleRate, float SilenceThresholdDb);
+
+	/** Consumes interleaved frames, a trailing partial frame is ignored. */
+	void Process(TConstArrayView<float> InterleavedSamples);
+
+	/** Returns statistics of all frames consumed so far. */
+	FAudioTrimmerAudioStats GetStats() const;
+
+	/** Analyzes an uncompressed WAV file in memory.
+	 * @return True if the data is an uncompressed WAV file and the statistics were computed. */
+	static bool AnalyzeWav(TConstArrayView<uint8> WavBytes, float SilenceThresholdDb, FAudioTrimmerAudioStats& OutStats);
+
+protected:
+	/** Coefficients of a second order filter, normalized by a0. */
+	struct FBiquad
+	{
+		double B0 = 1.0;
+		double B1 = 0.0;
+		double B2 = 0.0;
+		double A1 = 0.0;
+		double A2 = 0.0;
+	};
+
+	/** Last inputs and outputs of one filter stage of one channel. */
+	struct FBiquadState
+	{
+		double X1 = 0.0;
+		double X2 = 0.0;
+		double Y1 = 0.0;
+		double Y2 = 0.0;
+	};
+
+	/** Runs one sample through the filter, updating its state. */
+	static double FilterSample(const FBiquad& Filter, FBiquadState& State, double Input);
+
+	/** Converts a gated mean square into LUFS. */
+	static double GetLoudness(double MeanSquare);
+
+	int32 NumChannels = 0;
+
+	/** Pre-filter of the K-weighting, a high shelf modelling the head. */
+	FBiquad ShelfFilter;
+
+	/** Second stage of the K-weighting, a high pass. */
+	FBiquad HighPassFilter;
+
+	/** Two filter states for each channel, one per stage. */
+	TArray<FBiquadState> FilterStates;
+
+	/** Loudness weight of each channel, zero for the LFE and higher for surrounds. */
+	TArray<double> ChannelWeights;
+
+	/** Linear level below which a sample counts as silent. */
+	float SilenceThreshold = 0.f;
+
+	/** Largest absolute sample seen so far. */
+	float Peak = 0.f;
+
+	/** Sum of squares of all samples of all channels. */
+	double SumOfSquares = 0.0;
+
+	int64 NumSamples = 0;
+	int64 NumFrames = 0;
+	int64 NumSilentFrames = 0;
+
+	/** Number of frames in each 100 ms gating step. */
+	int64 StepFrames = 0;
+
+	/** Weighted sum of squared K-weighted samples of the current gating step. */
+	double StepSum = 0.0;
+
+	/** Frames consumed in the current gating step. */
+	int64 StepNumFrames = 0;
+
+	/** Mean square of every completed gating step, 400 ms blocks overlapping by 75% are built from four of them. */
+	TArray<double> StepMeanSquares;
+};
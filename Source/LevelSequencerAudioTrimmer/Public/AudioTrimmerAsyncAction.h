@@ -0,0 +1,93 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Kismet/BlueprintAsyncActionBase.h"
+//---
+#include "AudioTrimmerAsyncAction.generated.h"
+
+class ULevelSequence;
+class UAudioTrimmerJob;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAudioTrimmerAsyncProgressDelegate, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FAudioTrimmerAsyncAssetDelegate, float, Progress, const FString&, AssetPath, bool, bTrimmed, const FString&, Reason);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FAudioTrimmerAsyncFinishedDelegate, bool, bSucceeded, int32, NumTrimmed, int32, NumNotTrimmed);
+
+/**
+ * Async node that trims level sequences without freezing the editor.
+ * Every level sequence is queued as a job in UAudioTrimmerSubsystem, which processes batches of sound waves on worker threads while the editor keeps ticking.
+ * In Python, create the action with trim_level_sequences_async, bind its delegates and call start().
+ */
+UCLASS()
+class LEVELSEQUENCERAUDIOTRIMMERED_API UAudioTrimmerAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/** Is called after every processed batch with the overall progress of all level sequences. */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Trimmer")
+	FAudioTrimmerAsyncProgressDelegate OnProgress;
+
+	/** Is called with the path of every processed sound wave, and why it was skipped or failed if it was not trimmed. */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Trimmer")
+	FAudioTrimmerAsyncAssetDelegate OnAssetCompleted;
+
+	/** Is called once all level sequences are processed, succeeded if no job was cancelled, with the number of trimmed and not trimmed sound waves. */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Trimmer")
+	FAudioTrimmerAsyncFinishedDelegate OnFinished;
+
+	/** Queues trimming of all audio used by the given level sequences and returns at once.
+	 * @param LevelSequences The level sequences to trim, each one is a separate job with its own journal and report. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer", meta = (BlueprintInternalUseOnly = "true", ScriptCallable))
+	static UAudioTrimmerAsyncAction* TrimLevelSequencesAsync(const TArray<ULevelSequence*>& LevelSequences);
+
+	/** Queues the jobs of all level sequences. */
+	virtual void Activate() override;
+
+	/** Queues the jobs of all level sequences from scripts, which cannot call Activate, Blueprint nodes are activated automatically. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer", meta = (BlueprintInternalUseOnly = "true", ScriptCallable))
+	void Start() { Activate(); }
+
+	/** Lets the action be garbage collected once all its jobs are finished. */
+	virtual void SetReadyToDestroy() override;
+
+	/** Cancels all jobs of this action that are not finished yet. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	void Cancel();
+
+protected:
+	/** Is called after every processed batch of any job of this action. */
+	UFUNCTION()
+	void OnJobProgress(UAudioTrimmerJob* Job, float Progress);
+
+	/** Is called with the outcome of every sound wave of any job of this action. */
+	UFUNCTION()
+	void OnJobAssetCompleted(UAudioTrimmerJob* Job, const FString& AssetPath, bool bTrimmed, const FString& Reason);
+
+	/** Is called once any job of this action is finished or cancelled. */
+	UFUNCTION()
+	void OnJobCompleted(UAudioTrimmerJob* Job);
+
+	/** Returns the progress of all jobs together, in the [0, 1] range. */
+	float GetProgress() const;
+
+	/** The level sequences to trim. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ULevelSequence>> LevelSequences;
+
+	/** Jobs of all level sequences. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioTrimmerJob>> Jobs;
+
+	/** Number of jobs that are finished or cancelled. */
+	int32 NumCompletedJobs = 0;
+
+	/** Is true if any job was cancelled. */
+	bool bAnyJobCancelled = false;
+
+	/** Number of sound waves of all jobs that were trimmed. */
+	int32 NumTrimmed = 0;
+
+	/** Number of sound waves of all jobs that were skipped or failed. */
+	int32 NumNotTrimmed = 0;
+};
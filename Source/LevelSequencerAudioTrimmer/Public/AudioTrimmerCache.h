@@ -0,0 +1,49 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAudioTrimmerAudioStats;
+struct FAudioTrimmerFrameRange;
+
+/**
+ * Content-addressed cache of trimmed audio, works like the derived data cache but for trim results.
+ * Entries are keyed by the hash of the source audio, the requested frame range and the settings that change the output,
+ * and stored in a folder from UAudioTrimmerSettings that can be shared by the whole team over the network.
+ * Every entry is a trimmed WAV file along with the actual frame range it was cut from.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerCache
+{
+public:
+	/** Returns true if the cache is enabled in the settings. */
+	static bool IsEnabled();
+
+	/** Returns the folder of the cache from the settings, or the one in the 'Saved' folder of the project. */
+	static FString GetCacheDirectory();
+
+	/** Creates the key of the trimmed audio.
+	 * @param SourceHash Hash of the source audio, e.g. the payload identifier of the sound wave.
+	 * @param FrameRange The frames requested to keep, before snapping to zero crossings. */
+	static FString MakeKey(const FString& SourceHash, const FAudioTrimmerFrameRange& FrameRange);
+
+	/** Copies the cached trimmed audio of the given key into the output file.
+	 * @param Key The key created by MakeKey.
+	 * @param OutputPath Where to copy the trimmed WAV file.
+	 * @param OutFrameRange Receives the actual frames of the source the cached audio was cut from.
+	 * @param OutStats If set, receives the statistics stored with the entry, left untouched if there are none.
+	 * @return True on a cache hit. */
+	static bool Get(const FString& Key, const FString& OutputPath, FAudioTrimmerFrameRange& OutFrameRange, FAudioTrimmerAudioStats* OutStats = nullptr);
+
+	/** Stores the trimmed audio under the given key, an existing entry is kept as is.
+	 * @param Key The key created by MakeKey.
+	 * @param TrimmedPath The trimmed WAV file to store.
+	 * @param FrameRange The actual frames of the source the audio was cut from.
+	 * @param Stats If set, statistics of the trimmed audio stored with the entry, so cache hits do not have to read it again.
+	 * @return True if the entry was stored or already exists. */
+	static bool Put(const FString& Key, const FString& TrimmedPath, const FAudioTrimmerFrameRange& FrameRange, const FAudioTrimmerAudioStats* Stats = nullptr);
+
+protected:
+	/** Returns the path of the cached file of the given key without extension. */
+	static FString GetEntryPath(const FString& Key);
+};
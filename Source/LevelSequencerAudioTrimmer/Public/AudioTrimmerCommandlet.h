@@ -0,0 +1,68 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+//---
+#include "AudioTrimmerCommandlet.generated.h"
+
+struct FAssetData;
+
+/**
+ * Trims audio of level sequences from the command line, optionally spreading the work across several headless editor processes.
+ *
+ * Coordinator, partitions all level sequences under the given path into shards and launches one worker per shard:
+ *   UnrealEditor-Cmd.exe Project.uproject -run=AudioTrimmer -Path=/Game/Cinematics -Workers=8
+ *
+ * Worker, trims level sequences listed in the shard file, is launched by the coordinator:
+ *   UnrealEditor-Cmd.exe Project.uproject -run=AudioTrimmer -ShardFile=<path> -ShardIndex=<index>
+ *
+ * Manifest, only refreshes the usage manifest of all level sequences under the given path:
+ *   UnrealEditor-Cmd.exe Project.uproject -run=AudioTrimmer -Path=/Game -Manifest
+ *
+ * Level sequences sharing any sound wave always land in the same shard, so workers never save the same package.
+ */
+UCLASS()
+class LEVELSEQUENCERAUDIOTRIMMERED_API UAudioTrimmerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAudioTrimmerCommandlet();
+
+	/** Entry point of the commandlet, runs either the coordinator or the worker depending on the parameters. */
+	virtual int32 Main(const FString& Params) override;
+
+	/** Splits the given level sequences into disjoint shards of similar size.
+	 * Sequences that reference the same sound wave are kept together, so no package is processed by two shards.
+	 * @param LevelSequences All level sequences to trim.
+	 * @param NumShards Maximum number of shards to create.
+	 * @return Object paths of the level sequences of each non-empty shard. */
+	static TArray<TArray<FString>> PartitionIntoShards(const TArray<FAssetData>& LevelSequences, int32 NumShards);
+
+	/** Returns the folder where shard files and summaries are stored. */
+	static FString GetShardsDirectory();
+
+	/** Returns how many workers fit into the available memory, each one is a whole headless editor.
+	 * Every worker is expected to use the memory budget of commandlets, see UAudioTrimmerSettings::GetMemoryBudgetMB. */
+	static int32 GetDefaultNumWorkers();
+
+protected:
+	/** Finds all level sequences, launches one worker process per shard and merges their summaries.
+	 * @return Zero if all workers succeeded. */
+	int32 RunCoordinator(const FString& ContentPath, int32 NumWorkers);
+
+	/** Refreshes the usage manifest of level sequences under the given path without trimming anything.
+	 * @return Zero if the manifest was saved. */
+	int32 RunManifestUpdate(const FString& ContentPath);
+
+	/** Trims every level sequence listed in the shard file and writes the shard summary.
+	 * @return Zero if all level sequences were processed. */
+	int32 RunWorker(const FString& ShardFile, int32 ShardIndex);
+
+	/** Returns the executable used to launch headless workers. */
+	static FString GetWorkerExecutablePath();
+
+	/** Returns the path to the summary written by the worker of given shard. */
+	static FString GetShardSummaryPath(int32 ShardIndex);
+};
@@ -0,0 +1,67 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class ULevelSequence;
+class USoundWave;
+
+/**
+ * Non-destructive alternative to reimporting: trims sound waves only inside the cook process.
+ * Once cooking starts, the used range of every sound wave is read from the usage manifest,
+ * then every loaded sound wave gets its source payload trimmed in memory and every audio section is rebased onto it.
+ * The cooker builds platform data from the trimmed payload, while the source assets in the project stay untouched.
+ * Trimmed ranges are not a cook dependency of sound waves, so iterative cooks are refused instead of leaving sound waves and sections cooked against different ranges.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerCookTrimmer
+{
+public:
+	/** Returns true if the current process is a full cook and trimming at cook time is enabled in the settings. */
+	static bool ShouldTrimAtCookTime();
+
+	/** Returns true if the current cook keeps packages cooked by a previous one. */
+	static bool IsIterativeCook();
+
+	/** Collects usage of all sound waves and starts trimming loaded assets. */
+	void Start();
+
+	/** Stops trimming newly loaded assets. */
+	void Stop();
+
+protected:
+	/** Used range of one sound wave across all level sequences. */
+	struct FSoundUsage
+	{
+		int32 StartTimeMs = 0;
+		int32 EndTimeMs = 0;
+
+		/** Exact start of the trimmed payload, known once the sound wave was trimmed, negative before. */
+		double TrimStartTimeSec = -1.0;
+	};
+
+	/** Reads the used range of each sound wave from the usage manifest, refreshing it first for all mounted content roots. */
+	void BuildUsage();
+
+	/** Is called for every loaded asset to trim sound waves and rebase level sequences. */
+	void OnAssetLoaded(UObject* Object);
+
+	/** Trims the source payload of the sound wave in memory. */
+	bool TrimSoundWave(USoundWave* SoundWave);
+
+	/** Rebases all audio sections of the level sequence onto their trimmed sound waves. */
+	void RebaseLevelSequence(ULevelSequence* LevelSequence);
+
+	/** Returns the folder for temporary files of the cook trimmer. */
+	static FString GetTempDirectory();
+
+	/** Used range of every sound wave to trim, by sound wave path. */
+	TMap<FString, FSoundUsage> UsageBySound;
+
+	/** Loaded objects that were already processed, reloaded objects are processed again. */
+	TSet<TWeakObjectPtr<UObject>> ProcessedObjects;
+
+	/** Handle to the asset loaded delegate. */
+	FDelegateHandle OnAssetLoadedHandle;
+};
@@ -0,0 +1,61 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAudioTrimmerFrameRange;
+
+/**
+ * Vectorized sample kernels used by the trimmer stages, all operate on interleaved float samples.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerDsp
+{
+public:
+	/** Returns the largest absolute difference between the left and right channel of interleaved stereo samples. */
+	static float GetMaxStereoDifference(TConstArrayView<float> InterleavedStereo);
+
+	/** Returns the largest absolute difference between samples at the same positions of two arrays, compared up to the shorter one. */
+	static float GetMaxDifference(TConstArrayView<float> SamplesA, TConstArrayView<float> SamplesB);
+
+	/** Averages interleaved stereo samples into mono, appending them to the output. */
+	static void DownmixStereoToMono(TConstArrayView<float> InterleavedStereo, TArray<float>& OutMono);
+
+	/** Multiplies interleaved samples by a half-cosine ramp, rising from silence or falling into it.
+	 * @param InterleavedSamples Samples to modify in place.
+	 * @param NumChannels Number of interleaved channels.
+	 * @param FadeStartFrame Position of the first given frame within the fade.
+	 * @param FadeLength Total number of frames of the fade.
+	 * @param bFadeIn True to rise from silence, false to fall into silence. */
+	static void ApplyFade(TArrayView<float> InterleavedSamples, int32 NumChannels, int64 FadeStartFrame, int64 FadeLength, bool bFadeIn);
+
+	/** Moves both cut points of the range outwards to the closest zero crossing of the summed channels, so the used audio is kept intact.
+	 * @param FilePath The uncompressed WAV file to be trimmed.
+	 * @param InOutFrameRange The range to be kept, cut points without a zero crossing within the window stay as is.
+	 * @param WindowFrames How far each cut point can be moved. */
+	static void SnapToZeroCrossings(const FString& FilePath, FAudioTrimmerFrameRange& InOutFrameRange, int64 WindowFrames);
+
+	/** Fades in the beginning and fades out the end of the given WAV file in place.
+	 * @param FilePath The uncompressed WAV file to modify.
+	 * @param FadeInFrames Length of the fade in, zero to keep the beginning as is.
+	 * @param FadeOutFrames Length of the fade out, zero to keep the end as is. */
+	static bool ApplyEdgeFades(const FString& FilePath, int64 FadeInFrames, int64 FadeOutFrames);
+
+	/** Returns true if both channels of the given stereo WAV file are identical within the tolerance.
+	 * @param FilePath The uncompressed WAV file to analyze.
+	 * @param Tolerance The largest allowed absolute difference between the channels, in the [0, 1] range. */
+	static bool IsFakeStereo(const FString& FilePath, float Tolerance);
+
+	/** Returns true if the trimmed WAV file holds exactly the given frames of the source WAV file.
+	 * Sample bytes are compared straight from memory-mapped views when possible, otherwise both files are decoded chunk by chunk.
+	 * @param SourcePath The uncompressed WAV file that was trimmed.
+	 * @param TrimmedPath The trimmed WAV file.
+	 * @param SourceRange The frames of the source the trimmed file is expected to contain.
+	 * @param IgnoredHeadFrames Frames at the beginning of the trimmed file excluded from the comparison, e.g. because they were faded.
+	 * @param IgnoredTailFrames Frames at the end of the trimmed file excluded from the comparison. */
+	static bool VerifyTrimmedFile(const FString& SourcePath, const FString& TrimmedPath, const FAudioTrimmerFrameRange& SourceRange, int64 IgnoredHeadFrames, int64 IgnoredTailFrames);
+
+	/** Writes the average of both channels of the given stereo WAV file into a new mono WAV file of the same sample format.
+	 * @return True if the output file was successfully written. */
+	static bool DownmixFileToMono(const FString& InputPath, const FString& OutputPath);
+};
@@ -0,0 +1,91 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Progress of one sound wave through the trimming pipeline, stored in the journal in this order.
+ */
+enum class EAudioTrimmerJournalState : uint8
+{
+	None,
+	/** Used range is calculated, nothing is changed yet. */
+	Planned,
+	/** Source is exported into a temporary WAV file. */
+	Exported,
+	/** Temporary WAV file is trimmed, the asset is still untouched. */
+	Trimmed,
+	/** Trimmed audio is reimported and the sound wave package is saved, sections are not rebased yet. */
+	Reimported,
+	/** Sections are rebased and their packages are saved, the asset is done. */
+	Committed
+};
+
+/**
+ * Crash-safe, append-only log of a trimming run, stored in the 'Saved/AudioTrimmer/Journals' folder.
+ * Every state change of an asset is written and flushed as a separate line,
+ * so a run restarted after a crash can skip finished assets and roll back or finish partial ones.
+ * The journal file is removed once the whole run completes.
+ * Reading and appending is thread-safe, so assets processed in parallel can record their progress.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerJournal
+{
+public:
+	/** Journal entry of one asset, contains the latest state and all values recorded so far. */
+	struct FEntry
+	{
+		EAudioTrimmerJournalState State = EAudioTrimmerJournalState::None;
+		TMap<FString, FString> Values;
+	};
+
+	/** Opens the journal of the given run, loading entries left from a previous interrupted run.
+	 * @param RunName Unique name of the run, e.g. the path of the trimmed level sequence. */
+	explicit FAudioTrimmerJournal(const FString& RunName);
+
+	/** Returns the folder where all journals are stored. */
+	static FString GetJournalDirectory();
+
+	/** Returns the full path to this journal file. */
+	const FString& GetFilePath() const { return FilePath; }
+
+	/** Returns true if this journal contains entries left by an interrupted run. */
+	bool IsResumed() const { return bResumed; }
+
+	/** Returns the latest state of the given asset, or None if the asset is not in the journal. */
+	EAudioTrimmerJournalState GetState(const FString& AssetPath) const;
+
+	/** Returns the value recorded for the given asset, or empty string if it was never recorded. */
+	FString GetValue(const FString& AssetPath, const FString& Key) const;
+
+	/** Appends a new state of the asset to the journal and flushes it to disk.
+	 * @param AssetPath Path name of the asset.
+	 * @param State New state of the asset.
+	 * @param Values Additional values to record, such as temporary file paths or the trimmed range. */
+	void Append(const FString& AssetPath, EAudioTrimmerJournalState State, const TMap<FString, FString>& Values = {});
+
+	/** Returns true if every asset in the journal reached the Committed state. */
+	bool IsEveryAssetCommitted() const;
+
+	/** Deletes the journal file, is called when the whole run finished successfully. */
+	void Complete();
+
+	/** Returns the name of the given state as it is written to the journal. */
+	static const TCHAR* LexToString(EAudioTrimmerJournalState State);
+
+protected:
+	/** Reads all entries from the journal file. */
+	void Load();
+
+	/** Full path to the journal file. */
+	FString FilePath;
+
+	/** Latest entry of each asset. */
+	TMap<FString, FEntry> Entries;
+
+	/** True if entries were loaded from an interrupted run. */
+	bool bResumed = false;
+
+	/** Guards entries and the file against concurrent appends. */
+	mutable FCriticalSection CriticalSection;
+};
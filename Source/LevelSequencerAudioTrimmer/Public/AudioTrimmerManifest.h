@@ -0,0 +1,98 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+//---
+#include "AudioTrimmerWav.h"
+
+class ULevelSequence;
+struct FAssetData;
+
+/**
+ * Used samples of one sound wave by one audio section.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerSectionUsage
+{
+	/** Path name of the audio section. */
+	FString SectionPath;
+
+	/** Path name of the sound wave played by the section. */
+	FString SoundWavePath;
+
+	/** Sample rate the frame range is measured in. */
+	int32 SampleRate = 0;
+
+	/** Frames of the sound wave played by the section. */
+	FAudioTrimmerFrameRange FrameRange;
+
+	/** Returns the start of the used range in milliseconds. */
+	int32 GetStartTimeMs() const { return SampleRate > 0 ? static_cast<int32>(FrameRange.StartFrame * 1000 / SampleRate) : 0; }
+
+	/** Returns the end of the used range in milliseconds. */
+	int32 GetEndTimeMs() const { return SampleRate > 0 ? static_cast<int32>(FrameRange.EndFrame * 1000 / SampleRate) : 0; }
+};
+
+/**
+ * All audio usages of one level sequence package, along with the package file state they were collected from.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerSequenceUsage
+{
+	/** Modification time of the package file when the usages were collected. */
+	FDateTime Timestamp;
+
+	/** Size of the package file when the usages were collected. */
+	int64 FileSize = 0;
+
+	/** Usages of all audio sections of the level sequence. */
+	TArray<FAudioTrimmerSectionUsage> Sections;
+};
+
+/**
+ * Compact binary manifest of the used sample ranges of every sound wave across all level sequences of the project.
+ * Stored in 'Saved/AudioTrimmer/UsageManifest.bin' and refreshed incrementally:
+ * only level sequences whose package file changed since the last refresh are loaded again.
+ * Lets cooking, reporting and trimming know what audio is used without loading every level sequence.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerManifest
+{
+public:
+	/** Returns the path where the manifest of the project is stored. */
+	static FString GetDefaultFilePath();
+
+	/** Reads the manifest from the given file, replacing current entries.
+	 * @return False if the file is missing, corrupted or has an older version, the manifest is empty then. */
+	bool Load(const FString& FilePath = GetDefaultFilePath());
+
+	/** Writes the manifest to the given file.
+	 * @return True if the file was successfully written. */
+	bool Save(const FString& FilePath = GetDefaultFilePath()) const;
+
+	/** Rescans level sequences whose package files were added or changed since the last refresh and drops deleted ones.
+	 * @param ContentPath Only level sequences under this path are refreshed.
+	 * @return Number of level sequences that were rescanned or removed. */
+	int32 Refresh(const FString& ContentPath = TEXT("/Game"));
+
+	/** Drops level sequences that were deleted or renamed, and returns the ones whose package files were added or changed since the last refresh.
+	 * Nothing is loaded and the asset registry is not scanned, so it is cheap once the asset registry finished loading.
+	 * @param ContentPath Only level sequences under this path are collected.
+	 * @param OutNumRemoved Receives the number of dropped level sequences.
+	 * @return Level sequences to load and update. */
+	TArray<FAssetData> CollectChangedSequences(const FString& ContentPath, int32& OutNumRemoved);
+
+	/** Replaces the usages of the given level sequence with its current audio sections. */
+	void UpdateSequence(const ULevelSequence* LevelSequence);
+
+	/** Returns usages of all level sequences, by their package name. */
+	const TMap<FString, FAudioTrimmerSequenceUsage>& GetSequences() const { return Sequences; }
+
+	/** Returns usages of all level sequences grouped by the path name of their sound wave. */
+	TMap<FString, TArray<const FAudioTrimmerSectionUsage*>> GetUsagesBySound() const;
+
+protected:
+	/** Reads the modification time and size of the given package file, returns false if the package does not exist. */
+	static bool GetPackageFileState(const FString& PackageName, FDateTime& OutTimestamp, int64& OutFileSize);
+
+	/** Usages of all level sequences, by their package name. */
+	TMap<FString, FAudioTrimmerSequenceUsage> Sequences;
+};
@@ -0,0 +1,81 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+//---
+#include "AudioTrimmerTypes.h"
+
+/**
+ * Structured summary of a trimming run, written as JSON for build dashboards and as HTML for people,
+ * stored in the 'Saved/AudioTrimmer/Reports' folder.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerReport
+{
+public:
+	/** Sums of all assets of the report. */
+	struct FTotals
+	{
+		int32 NumAssets = 0;
+		int32 NumTrimmed = 0;
+		int32 NumSkipped = 0;
+		int32 NumFailed = 0;
+		int64 OriginalBytes = 0;
+		int64 NewBytes = 0;
+		double OriginalDurationSec = 0.0;
+		double NewDurationSec = 0.0;
+	};
+
+	/** Starts the report of the given run.
+	 * @param InRunName Name of the run, e.g. the path of the trimmed level sequence. */
+	explicit FAudioTrimmerReport(const FString& InRunName);
+
+	/** Returns the folder where all reports are stored. */
+	static FString GetReportsDirectory();
+
+	/** Adds the outcome of one sound wave. */
+	void AddAsset(const FAudioTrimmerAssetReport& AssetReport);
+
+	/** Adds all assets of another report, e.g. to merge reports of several workers.
+	 * The duration becomes the longest one, since merged runs can overlap in time. */
+	void Append(const FAudioTrimmerReport& Other);
+
+	/** Stops the clock of the run. */
+	void Finish();
+
+	/** Returns outcomes of all sound waves. */
+	const TArray<FAudioTrimmerAssetReport>& GetAssets() const { return Assets; }
+
+	/** Returns sums of all assets. */
+	FTotals GetTotals() const;
+
+	/** Writes the report as '.json' and '.html' files next to each other.
+	 * @return The path of the JSON file without extension, empty if writing failed. */
+	FString Save() const;
+
+	/** Writes the report as JSON to the given file. */
+	bool SaveJson(const FString& FilePath) const;
+
+	/** Writes the report as an HTML table to the given file. */
+	bool SaveHtml(const FString& FilePath) const;
+
+	/** Reads a report previously written by SaveJson.
+	 * @return True if the file was read and parsed. */
+	bool LoadJson(const FString& FilePath);
+
+	/** Returns the name of the given status as it is written to the report. */
+	static const TCHAR* LexToString(EAudioTrimmerAssetStatus Status);
+
+protected:
+	/** Name of the run. */
+	FString RunName;
+
+	/** When the run started. */
+	FDateTime StartTime;
+
+	/** Duration of the whole run in seconds, set by Finish. */
+	double TotalSeconds = 0.0;
+
+	/** Outcomes of all sound waves. */
+	TArray<FAudioTrimmerAssetReport> Assets;
+};
@@ -0,0 +1,72 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Streaming polyphase windowed-sinc resampler for interleaved float audio.
+ * The conversion ratio is reduced to L/M, one Kaiser-windowed filter phase is precomputed for each of the L output positions,
+ * so every output sample is a single SIMD dot product of contiguous input history and the taps of its phase.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerResampler
+{
+public:
+	/** Number of filter taps used for each output sample when upsampling, kept a multiple of SIMD width.
+	 * Downsampling scales it by the decimation ratio, so the transition band stays as narrow relative to the output rate.
+	 * Measured stop-band attenuation above 1.06 of the output Nyquist frequency is about 83 dB for 2:1, 48000 -> 44100 and 44100 -> 48000 Hz. */
+	static constexpr int32 BaseTapsPerPhase = 48;
+
+	/** Largest number of filter phases, ratios that would need more are rejected. */
+	static constexpr int32 MaxNumPhases = 4096;
+
+	/** Prepares the filter for converting between the given rates.
+	 * @return True if the ratio is supported. */
+	bool Init(uint32 InSourceRate, uint32 InTargetRate, int32 InNumChannels);
+
+	/** Consumes interleaved input frames and appends all output frames that can already be produced. */
+	void Process(TConstArrayView<float> InterleavedInput, TArray<float>& OutInterleaved);
+
+	/** Produces the remaining output frames, treating the input after its end as silence. */
+	void Flush(TArray<float>& OutInterleaved);
+
+	/** Returns the number of output frames produced for the given number of input frames. */
+	int64 GetNumOutputFrames(int64 NumInputFrames) const;
+
+	/** Resamples the given WAV file into a new WAV file of the same sample format, streaming it in fixed-size chunks.
+	 * @param InputPath The uncompressed WAV file to read.
+	 * @param OutputPath The WAV file to create.
+	 * @param TargetSampleRate The sample rate of the output file.
+	 * @return True if the output file was successfully written. */
+	static bool ResampleFile(const FString& InputPath, const FString& OutputPath, uint32 TargetSampleRate);
+
+protected:
+	/** Produces output frames while there is enough input history, or until the expected output length when flushing. */
+	void ProduceFrames(TArray<float>& OutInterleaved, int64 MaxOutputFrames);
+
+	/** Interpolation factor, number of filter phases. */
+	int64 UpFactor = 1;
+
+	/** Decimation factor. */
+	int64 DownFactor = 1;
+
+	/** Number of filter taps used for each output sample, BaseTapsPerPhase scaled by the decimation ratio. */
+	int32 TapsPerPhase = BaseTapsPerPhase;
+
+	int32 NumChannels = 0;
+
+	/** Taps of every phase, stored reversed, so they line up with the input history in memory. */
+	TArray<float> PhaseTaps;
+
+	/** Deinterleaved input history of every channel, starting at the absolute frame BufferStartFrame. */
+	TArray<TArray<float>> ChannelBuffers;
+
+	/** Absolute input frame stored at the beginning of the channel buffers, negative for the leading silence. */
+	int64 BufferStartFrame = 0;
+
+	/** Number of input frames consumed so far. */
+	int64 NumInputFrames = 0;
+
+	/** Index of the next output frame to produce. */
+	int64 NextOutputFrame = 0;
+};
@@ -0,0 +1,95 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+//---
+#include "AudioTrimmerJournal.h"
+#include "AudioTrimmerReport.h"
+#include "AudioTrimmerTypes.h"
+#include "Tasks/Task.h"
+
+/**
+ * One trimming run over a list of plans, processed batch by batch.
+ * A batch of sound waves is exported on the game thread, their files are trimmed on worker threads, and once all of them are processed they are committed on the game thread,
+ * so a caller can spread a long run over editor ticks, report progress and stop between batches without leaving anything half trimmed.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerRun
+{
+public:
+	/** Starts the run, nothing is processed before the first step.
+	 * @param InRunName Unique name of the run, names its journal and report.
+	 * @param InAssetPlans The plans to process, sorted by priority.
+	 * @param InCallbacks Progress and per-asset callbacks. */
+	FAudioTrimmerRun(const FString& InRunName, const TArray<FAudioTrimmerAssetPlan>& InAssetPlans, const FAudioTrimmerRunCallbacks& InCallbacks = {});
+
+	/** Starts the next batch of plans if none is in flight, and commits the batch in flight once its files are processed.
+	 * Finishes the run once all plans are processed or it is stopped.
+	 * @param bWaitForBatch If true, blocks until the batch in flight is processed while keeping async loading going, otherwise returns at once if it is still processed.
+	 * @return True if plans are left for the next step. */
+	bool Step(bool bWaitForBatch = true);
+
+	/** Stops the run, reports remaining plans as skipped and saves the report, does nothing if the run is already finished.
+	 * A batch in flight is waited for and committed first.
+	 * @param StopReason Why the remaining plans are skipped. */
+	void Finish(const FString& StopReason);
+
+	/** Returns true while files of a batch are processed on worker threads. */
+	bool IsBatchInFlight() const { return !FileTasks.IsEmpty(); }
+
+	/** Returns the processed part of the plans in the [0, 1] range. */
+	float GetProgress() const { return AssetPlans.Num() > 0 ? static_cast<float>(PlanIndex) / AssetPlans.Num() : 1.f; }
+
+	/** Returns true once the run is finished. */
+	bool IsFinished() const { return bFinished; }
+
+	/** Returns true if every plan was processed. */
+	bool IsCompleted() const { return PlanIndex == AssetPlans.Num(); }
+
+protected:
+	/** Exports the next batch of plans and launches the processing of their files on worker threads. */
+	void StartBatch();
+
+	/** Commits the processed batch, then finishes the run if it is complete, stopped or out of time.
+	 * @return True if plans are left for the next step. */
+	bool CommitBatch();
+
+	/** Commits every job of the processed batch and reports them. */
+	void CommitBatchJobs();
+
+	/** Adds the outcome of one sound wave to the report and notifies the callback. */
+	void AddAsset(const FAudioTrimmerAssetReport& AssetReport);
+
+	/** Name of the run. */
+	FString RunName;
+
+	/** The plans to process, sorted by priority. */
+	TArray<FAudioTrimmerAssetPlan> AssetPlans;
+
+	/** Progress and per-asset callbacks. */
+	FAudioTrimmerRunCallbacks Callbacks;
+
+	/** Lets a run interrupted by a crash continue where it stopped. */
+	FAudioTrimmerJournal Journal;
+
+	/** Outcome of every sound wave of the run. */
+	FAudioTrimmerReport Report;
+
+	/** When the run started, for the run time limit. */
+	double StartTime = 0.0;
+
+	/** Index of the next plan to process. */
+	int32 PlanIndex = 0;
+
+	/** Jobs of the batch in flight, processed by the file tasks, so the array is never changed while they run. */
+	TArray<FAudioTrimmerAssetJob> BatchJobs;
+
+	/** Process the files of the batch in flight, empty if no batch is in flight. */
+	TArray<UE::Tasks::FTask> FileTasks;
+
+	/** Is true if the batch in flight was cut short by the run time limit. */
+	bool bTimeLimitReached = false;
+
+	/** Is true once the run is finished. */
+	bool bFinished = false;
+};
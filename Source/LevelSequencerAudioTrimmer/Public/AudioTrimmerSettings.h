@@ -0,0 +1,132 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "Engine/DeveloperSettings.h"
+#include "Engine/EngineTypes.h"
+//---
+#include "AudioTrimmerSettings.generated.h"
+
+/**
+ * Project settings of the Level Sequencer Audio Trimmer, found in 'Project Settings > Plugins > Audio Trimmer'.
+ */
+UCLASS(Config = "Editor", DefaultConfig, meta = (DisplayName = "Audio Trimmer"))
+class LEVELSEQUENCERAUDIOTRIMMERED_API UAudioTrimmerSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the settings of the Audio Trimmer. */
+	static const UAudioTrimmerSettings& Get() { return *GetDefault<UAudioTrimmerSettings>(); }
+
+	/** Returns the category where these settings are shown. */
+	virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+
+	/** Memory budget of commandlets if MemoryBudgetMB is disabled, so headless runs over a whole project do not keep every trimmed asset loaded. */
+	static constexpr int32 DefaultCommandletMemoryBudgetMB = 4096;
+
+	/** Returns the memory budget in megabytes that applies to this process, 0 if there is none. */
+	int32 GetMemoryBudgetMB() const { return MemoryBudgetMB > 0 ? MemoryBudgetMB : (IsRunningCommandlet() ? DefaultCommandletMemoryBudgetMB : 0); }
+
+	/** Time in milliseconds kept before the used range of each sound. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming", meta = (ClampMin = "0", Units = "ms"))
+	int32 HeadPaddingMs = 0;
+
+	/** Time in milliseconds kept after the used range of each sound. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming", meta = (ClampMin = "0", Units = "ms"))
+	int32 TailPaddingMs = 0;
+
+	/** Sounds that would be reduced by fewer bytes are skipped before anything is exported. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming", meta = (ClampMin = "0", Units = "Bytes"))
+	int64 MinSavedBytes = 0;
+
+	/** Sounds that would be reduced by a smaller percentage of their size are skipped before anything is exported. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming", meta = (ClampMin = "0", ClampMax = "100", Units = "Percent"))
+	float MinSavedPercent = 0.f;
+
+	/** If set, a run stops starting new sounds once it took longer than this, sounds with the biggest savings are trimmed first. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming", meta = (ClampMin = "0", Units = "Minutes"))
+	float MaxRunDurationMinutes = 0.f;
+
+	/** If true, trimmed uncompressed audio is compared against the source samples it was cut from, any mismatch cancels its reimport. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming")
+	bool bVerifyTrimmedAudio = false;
+
+	/** If true, compressed sources that need ffmpeg are streamed through its standard input and output, so neither the export nor the reimport goes through temporary files.
+	 * If the trim cache, click-free cuts, verification, downmix or resampling are enabled, the source is decoded through ffmpeg into a temporary WAV file instead, so they apply as well. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Trimming")
+	bool bPipeFfmpegAudio = false;
+
+	/** If true, peak, RMS, EBU R128 loudness and silence of trimmed audio are measured while it is cut, and stored in the report. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Analysis")
+	bool bAnalyzeTrimmedAudio = true;
+
+	/** If true, measured levels are also stored in the package metadata of the sound wave under 'AudioTrimmer.' keys. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Analysis", meta = (EditCondition = "bAnalyzeTrimmedAudio"))
+	bool bWriteAudioStatsMetaData = false;
+
+	/** Frames where every channel is quieter than this level are counted as silence. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Analysis", meta = (EditCondition = "bAnalyzeTrimmedAudio", ClampMin = "-144", ClampMax = "0"))
+	float SilenceThresholdDb = -60.f;
+
+	/** If true, trimmed audio is stored by the hash of its source and range, so the same trim is never repeated on any machine using the same cache folder. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Cache")
+	bool bUseTrimCache = false;
+
+	/** Local or network folder of the trim cache, relative paths start at the project folder, 'Saved/AudioTrimmer/Cache' if empty. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Cache", meta = (EditCondition = "bUseTrimCache"))
+	FDirectoryPath TrimCacheDirectory;
+
+	/** If true, trimmed audio with a higher sample rate than TargetSampleRate is resampled down before it is reimported. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Resampling")
+	bool bResampleToTargetRate = false;
+
+	/** The sample rate trimmed audio is converted to, sounds with the same or lower rate are left as is. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Resampling", meta = (EditCondition = "bResampleToTargetRate", ClampMin = "8000", ClampMax = "192000"))
+	int32 TargetSampleRate = 48000;
+
+	/** If true, stereo audio whose channels are identical within FakeStereoTolerance is written as mono before it is reimported. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Channels")
+	bool bDownmixFakeStereo = false;
+
+	/** The largest difference between left and right samples, in the [0, 1] range, for audio still considered fake stereo. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Channels", meta = (EditCondition = "bDownmixFakeStereo", ClampMin = "0", ClampMax = "0.1"))
+	float FakeStereoTolerance = 0.0001f;
+
+	/** If true, cut points are moved outwards to the closest zero crossing, so trimmed audio starts and ends without a click. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Click-Free Cuts")
+	bool bSnapToZeroCrossings = false;
+
+	/** How far in milliseconds each cut point can be moved while searching for a zero crossing. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Click-Free Cuts", meta = (EditCondition = "bSnapToZeroCrossings", ClampMin = "0", ClampMax = "50", Units = "ms"))
+	float ZeroCrossingWindowMs = 5.f;
+
+	/** If true, short fades are applied to the edges that were cut, hiding clicks where no zero crossing was found. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Click-Free Cuts")
+	bool bApplyEdgeFades = false;
+
+	/** Length in milliseconds of the fade applied to each cut edge. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Click-Free Cuts", meta = (EditCondition = "bApplyEdgeFades", ClampMin = "0", ClampMax = "50", Units = "ms"))
+	float EdgeFadeMs = 2.f;
+
+	/** How many level sequences waiting to be trimmed are loaded in the background, along with their sound waves, while the current ones are trimmed. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Loading", meta = (ClampMin = "0", ClampMax = "64"))
+	int32 PrefetchCount = 4;
+
+	/** Resident memory in megabytes above which loaded assets are released and garbage is collected between level sequences of long runs.
+	 * 0 disables the budget in the editor, commandlets then use DefaultCommandletMemoryBudgetMB. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Loading", meta = (ClampMin = "0", Units = "Megabytes"))
+	int32 MemoryBudgetMB = 0;
+
+	/** If true, cooking trims every used sound wave and rebases its sections in memory only, so source assets are never modified. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Cooking")
+	bool bTrimAtCookTime = false;
+
+	/** If true, saving a level sequence in the editor queues trimming of sound waves whose used range across all level sequences shrank. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Watch", meta = (ConfigRestartRequired = true))
+	bool bWatchLevelSequences = false;
+
+	/** How long in seconds the editor waits after the last saved level sequence before queued sound waves are trimmed. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Watch", meta = (EditCondition = "bWatchLevelSequences", ClampMin = "0", Units = "Seconds"))
+	float WatchDelaySeconds = 5.f;
+};
@@ -0,0 +1,243 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "EditorSubsystem.h"
+//---
+#include "AudioTrimmerTypes.h"
+#include "Async/Future.h"
+#include "Containers/Ticker.h"
+#include "Engine/StreamableManager.h"
+#include <atomic>
+//---
+#include "AudioTrimmerSubsystem.generated.h"
+
+class FAudioTrimmerRun;
+class ULevelSequence;
+class UMovieSceneAudioSection;
+class UAudioTrimmerJob;
+
+/**
+ * Lifecycle of a queued trimming run.
+ */
+UENUM(BlueprintType)
+enum class EAudioTrimmerJobState : uint8
+{
+	/** Waiting for the previous jobs to finish. */
+	Queued,
+	/** Sound waves are being trimmed. */
+	Running,
+	/** All planned sound waves were processed. */
+	Succeeded,
+	/** Stopped before all sound waves were processed, by a request or the run time limit. */
+	Cancelled
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAudioTrimmerJobCompleted, UAudioTrimmerJob*, Job);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAudioTrimmerJobProgress, UAudioTrimmerJob*, Job, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnAudioTrimmerJobAssetCompleted, UAudioTrimmerJob*, Job, const FString&, AssetPath, bool, bTrimmed, const FString&, Reason);
+
+/**
+ * Handle of one trimming run queued in UAudioTrimmerSubsystem.
+ * Reports progress and the outcome of every sound wave, can be cancelled at any time, and completes both its future and its delegate once finished.
+ * Cancelling a running job stops it after the sound waves in flight are committed, so no asset is left half trimmed.
+ */
+UCLASS(BlueprintType, Transient)
+class LEVELSEQUENCERAUDIOTRIMMERED_API UAudioTrimmerJob : public UObject
+{
+	GENERATED_BODY()
+
+	friend class UAudioTrimmerSubsystem;
+
+public:
+	/** Is called on the game thread once the job is finished or cancelled. */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Trimmer")
+	FOnAudioTrimmerJobCompleted OnCompleted;
+
+	/** Is called on the game thread after every processed batch of sound waves. */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Trimmer")
+	FOnAudioTrimmerJobProgress OnProgress;
+
+	/** Is called on the game thread with the outcome of every sound wave, including skipped ones. */
+	UPROPERTY(BlueprintAssignable, Category = "Audio Trimmer")
+	FOnAudioTrimmerJobAssetCompleted OnAssetCompleted;
+
+	/** Returns the name of the run, the same as its journal and report. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	FString GetRunName() const { return RunName; }
+
+	/** Returns the current state of the job. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	EAudioTrimmerJobState GetState() const { return State; }
+
+	/** Returns the part of planned sound waves already processed, in the [0, 1] range. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	float GetProgress() const { return Progress; }
+
+	/** Returns the number of sound waves that failed to be trimmed so far. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	int32 GetNumFailed() const { return NumFailed; }
+
+	/** Returns true if the job is finished or cancelled. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	bool IsDone() const { return State == EAudioTrimmerJobState::Succeeded || State == EAudioTrimmerJobState::Cancelled; }
+
+	/** Requests the job to stop, a queued job never starts. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	void Cancel() { bCancelRequested = true; }
+
+	/** Returns true if cancellation was requested, safe to call from any thread. */
+	bool IsCancelRequested() const { return bCancelRequested; }
+
+	/** Returns the future set to the final state of the job. */
+	TSharedFuture<EAudioTrimmerJobState> GetFuture() const { return Future; }
+
+protected:
+	/** Finishes the job, fulfilling its future and broadcasting the delegate. */
+	void Complete(EAudioTrimmerJobState FinalState);
+
+	/** Name of the run, the same as its journal and report. */
+	FString RunName;
+
+	/** Creates plans once the job starts, so the trimming policy sees the assets as they are then. */
+	TFunction<TArray<FAudioTrimmerAssetPlan>()> Planner;
+
+	/** Assets used by the planner, kept alive while the job waits in the queue. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UObject>> ReferencedObjects;
+
+	/** Assets the planner loads, loaded in the background while previous jobs run. */
+	TArray<FSoftObjectPath> AssetsToPrefetch;
+
+	/** Keeps prefetched assets loaded until the job is finished, null if nothing was prefetched yet. */
+	TSharedPtr<FStreamableHandle> PrefetchHandle = nullptr;
+
+	/** Current state of the job. */
+	EAudioTrimmerJobState State = EAudioTrimmerJobState::Queued;
+
+	/** The part of planned sound waves already processed, in the [0, 1] range. */
+	float Progress = 0.f;
+
+	/** Number of sound waves that failed to be trimmed so far. */
+	int32 NumFailed = 0;
+
+	/** Is set by Cancel from any thread. */
+	std::atomic<bool> bCancelRequested = false;
+
+	/** Is fulfilled with the final state. */
+	TPromise<EAudioTrimmerJobState> Promise;
+
+	/** Shared future of the promise. */
+	TSharedFuture<EAudioTrimmerJobState> Future = Promise.GetFuture().Share();
+};
+
+/**
+ * Global scheduler of trimming runs of the editor.
+ * Menus, Blueprints, Python, the watcher and commandlets all submit jobs here, and jobs run one after another in submission order,
+ * so runs never race each other over the same assets.
+ * Outside of Play In Editor, each editor tick starts or commits one batch of sound waves of the running job, whose files are processed on worker threads meanwhile, so the editor stays responsive,
+ * or at once with a progress dialog when RunQueuedJobs or RunJob is called.
+ */
+UCLASS()
+class LEVELSEQUENCERAUDIOTRIMMERED_API UAudioTrimmerSubsystem : public UEditorSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the subsystem of the editor, or null if there is no editor, e.g. in a game. */
+	static UAudioTrimmerSubsystem* Get();
+
+	/** Queues trimming of all audio used by the given level sequence.
+	 * @return The handle of the queued job. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	UAudioTrimmerJob* EnqueueLevelSequence(const ULevelSequence* LevelSequence);
+
+	/** Queues trimming of all audio used by the level sequence at the given path, the level sequence is loaded in the background while previous jobs run.
+	 * @return The handle of the queued job. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	UAudioTrimmerJob* EnqueueLevelSequencePath(const FSoftObjectPath& LevelSequencePath);
+
+	/** Queues trimming of the sound waves played by the given audio sections.
+	 * @return The handle of the queued job. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	UAudioTrimmerJob* EnqueueAudioSections(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections);
+
+	/** Queues a run that processes the plans created by the given planner once the job starts.
+	 * @param RunName Unique name of the run, names its journal and report.
+	 * @param Planner Creates the plans, is called on the game thread when the job starts.
+	 * @param ReferencedObjects Assets used by the planner, kept alive while the job is queued.
+	 * @param AssetsToPrefetch Assets the planner loads, loaded in the background while previous jobs run.
+	 * @return The handle of the queued job. */
+	UAudioTrimmerJob* EnqueueJob(const FString& RunName, TFunction<TArray<FAudioTrimmerAssetPlan>()> Planner, const TArray<UObject*>& ReferencedObjects, const TArray<FSoftObjectPath>& AssetsToPrefetch = {});
+
+	/** Finishes the running job and runs all queued jobs right away, e.g. from a commandlet or a script that needs the results.
+	 * Does nothing if called from a callback of a job. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	void RunQueuedJobs();
+
+	/** Finishes the running job, then runs the given queued job right away, while other queued jobs keep waiting for their turn.
+	 * Does nothing if called from a callback of a job.
+	 * @param Job The job to run, returned when it was queued. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	void RunJob(UAudioTrimmerJob* Job);
+
+	/** Cancels the running job and all queued jobs. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	void CancelAllJobs();
+
+	/** Returns true while a job is being run. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	bool IsRunningJob() const { return RunningJob != nullptr; }
+
+	/** Returns the running job followed by all queued jobs. */
+	UFUNCTION(BlueprintPure, Category = "Audio Trimmer")
+	TArray<UAudioTrimmerJob*> GetJobs() const;
+
+protected:
+	/** Starts ticking the queue. */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Cancels all jobs and stops ticking the queue. */
+	virtual void Deinitialize() override;
+
+	/** Is called by the ticker to process the next batch of the running job, or to start the next queued job. */
+	bool Tick(float DeltaTime);
+
+	/** Plans the next queued job and makes it the running one, jobs without anything to trim are completed at once.
+	 * @return True if a job is running. */
+	bool StartNextJob();
+
+	/** Plans the given job that was taken out of the queue and makes it the running one, it is completed at once if there is nothing to trim.
+	 * @return True if the job is running. */
+	bool StartJob(UAudioTrimmerJob* Job);
+
+	/** Steps the running job until it is finished, showing a progress dialog that lets people cancel it. */
+	void FinishRunningJob();
+
+	/** Processes the next batch of the running job, completes the job once its run is finished.
+	 * @param bWaitForBatch If true, blocks until the batch in flight is processed, otherwise it is only committed once its files are processed. */
+	void StepRunningJob(bool bWaitForBatch);
+
+	/** Starts loading assets of the next queued jobs in the background, up to the prefetch count from the settings. */
+	void PrefetchQueuedJobs();
+
+	/** Loads assets of queued jobs in the background. */
+	FStreamableManager StreamableManager;
+
+	/** Jobs waiting to run, in submission order. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioTrimmerJob>> QueuedJobs;
+
+	/** The job being run, null if none. */
+	UPROPERTY(Transient)
+	TObjectPtr<UAudioTrimmerJob> RunningJob = nullptr;
+
+	/** The run of the running job, processed batch by batch. */
+	TSharedPtr<FAudioTrimmerRun> Run = nullptr;
+
+	/** Is true while a batch is processed, so callbacks of a job never start other jobs re-entrantly. */
+	bool bIsStepping = false;
+
+	/** Handle to the ticker that starts queued jobs. */
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,163 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Memory/SharedBuffer.h"
+//---
+#include "AudioTrimmerAnalyzer.h"
+
+class UMovieSceneAudioSection;
+class USoundWave;
+
+/**
+ * All usages of one sound wave within a trimming run.
+ * The sound wave is trimmed once to the union of the used ranges, then every section is rebased onto the trimmed audio.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerAssetPlan
+{
+	/** The sound wave to trim. */
+	USoundWave* SoundWave = nullptr;
+
+	/** All audio sections playing this sound wave. */
+	TArray<UMovieSceneAudioSection*> AudioSections;
+
+	/** Start of the used range within the sound wave in milliseconds. */
+	int32 StartTimeMs = MAX_int32;
+
+	/** End of the used range within the sound wave in milliseconds. */
+	int32 EndTimeMs = 0;
+
+	/** Total length of the sound wave in milliseconds. */
+	int32 DurationMs = 0;
+
+	/** Size in bytes of the source audio stored in the sound wave. */
+	int64 SourceSizeBytes = 0;
+
+	/** Why this sound wave is not trimmed, empty if it has to be trimmed. */
+	FString SkipReason;
+
+	/** Returns the part of the sound wave that is used, in the [0, 1] range. */
+	float GetUsedFraction() const
+	{
+		return DurationMs > 0 ? FMath::Clamp(static_cast<float>(EndTimeMs - StartTimeMs) / DurationMs, 0.f, 1.f) : 1.f;
+	}
+
+	/** Expected size of the source audio after trimming and the configured format conversions. */
+	int64 EstimatedTrimmedBytes = INDEX_NONE;
+
+	/** Returns the estimated number of source bytes removed by trimming. */
+	int64 GetEstimatedSavedBytes() const
+	{
+		const int64 TrimmedBytes = EstimatedTrimmedBytes != INDEX_NONE ? EstimatedTrimmedBytes : static_cast<int64>(SourceSizeBytes * GetUsedFraction());
+		return FMath::Max<int64>(SourceSizeBytes - TrimmedBytes, 0);
+	}
+
+	/** Extends the used range to include the given one. */
+	void AddUsedRange(int32 InStartTimeMs, int32 InEndTimeMs)
+	{
+		StartTimeMs = FMath::Min(StartTimeMs, InStartTimeMs);
+		EndTimeMs = FMath::Max(EndTimeMs, InEndTimeMs);
+	}
+};
+
+/**
+ * Final outcome of one sound wave in a run.
+ */
+enum class EAudioTrimmerAssetStatus : uint8
+{
+	/** Not processed yet. */
+	Pending,
+	/** Sound wave is trimmed and its sections are rebased. */
+	Trimmed,
+	/** Sound wave is left as is on purpose, see the reason. */
+	Skipped,
+	/** Any stage failed, the sound wave is left as is, see the reason. */
+	Failed
+};
+
+/**
+ * Sizes, durations and stage timings of one sound wave in a run, written into the run report.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerAssetReport
+{
+	/** Path name of the sound wave. */
+	FString AssetPath;
+
+	/** How the sound wave was processed. */
+	EAudioTrimmerAssetStatus Status = EAudioTrimmerAssetStatus::Pending;
+
+	/** Why the sound wave was skipped or failed, empty if it was trimmed. */
+	FString Reason;
+
+	/** Size in bytes of the source audio before and after the run. */
+	int64 OriginalBytes = 0;
+	int64 NewBytes = 0;
+
+	/** Length in seconds of the sound wave before and after the run. */
+	double OriginalDurationSec = 0.0;
+	double NewDurationSec = 0.0;
+
+	/** Part of the sound wave used by its sections, in the [0, 100] range. */
+	float UsedPercent = 0.f;
+
+	/** Time spent in each stage in seconds. */
+	double ExportSeconds = 0.0;
+	double ProcessSeconds = 0.0;
+	double CommitSeconds = 0.0;
+
+	/** Levels of the trimmed audio, measured while it was cut. */
+	FAudioTrimmerAudioStats Stats;
+
+	/** Additional changes applied to the audio, such as the downmix to mono. */
+	TArray<FString> Notes;
+};
+
+/**
+ * Progress of one asset plan through the stages of a run:
+ * exported on the game thread, trimmed and converted on a worker thread, then reimported and committed on the game thread.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerAssetJob
+{
+	/** The plan being processed. */
+	const FAudioTrimmerAssetPlan* AssetPlan = nullptr;
+
+	/** Exported source audio, empty if the sound wave does not have to be trimmed anymore. */
+	FString ExportPath;
+
+	/** Hash of the source audio of the sound wave, identifies its trim results in the cache. */
+	FString SourceHash;
+
+	/** Trimmed and converted audio to reimport, empty until the file stage succeeded. */
+	FString ReimportPath;
+
+	/** Source audio piped to ffmpeg instead of being exported, null unless the source is compressed and piping is enabled. */
+	FSharedBuffer SourcePayload;
+
+	/** Trimmed audio read from ffmpeg to reimport from memory, empty unless the source was piped. */
+	TArray<uint8> ReimportBytes;
+
+	/** True if the sound wave was already reimported by an interrupted run, so only its sections are left to rebase. */
+	bool bReimported = false;
+
+	/** True if an interrupted run finished this sound wave completely. */
+	bool bCommitted = false;
+
+	/** True once any stage failed, later stages skip the job. */
+	bool bFailed = false;
+
+	/** Outcome of the job, filled by every stage. */
+	FAudioTrimmerAssetReport Report;
+};
+
+/**
+ * Optional callbacks of a trimming run, called on the game thread.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerRunCallbacks
+{
+	/** Is called after every batch with the processed part of the plans in the [0, 1] range, returns false to stop the run. */
+	TFunction<bool(float Progress)> OnProgress;
+
+	/** Is called with the outcome of every sound wave, including skipped ones. */
+	TFunction<void(const FAudioTrimmerAssetReport& AssetReport)> OnAssetCompleted;
+};
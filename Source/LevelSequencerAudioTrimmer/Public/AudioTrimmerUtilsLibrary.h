@@ -4,8 +4,13 @@
 
 #include "Kismet/BlueprintFunctionLibrary.h"
 //---
+#include "AudioTrimmerTypes.h"
+//---
 #include "AudioTrimmerUtilsLibrary.generated.h"
 
+class FAudioTrimmerJournal;
+struct FAudioTrimmerFrameRange;
+class UMovieScene;
 class UMovieSceneAudioSection;
 class ULevelSequence;
 class USoundWave;
@@ -21,9 +26,96 @@ class LEVELSEQUENCERAUDIOTRIMMERED_API UAudioTrimmerUtilsLibrary : public UBluep
 	GENERATED_BODY()
 
 public:
-	/** Runs the audio trimmer for given level sequence. */
+	/** Runs the audio trimmer for given level sequence.
+	 * The run goes through the queue of UAudioTrimmerSubsystem, so it never races other runs, and is finished on return.
+	 * @return True if all sound waves were processed and none of them failed. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	static bool RunLevelSequenceAudioTrimmer(const ULevelSequence* LevelSequence);
+
+	/** Runs the audio trimmer only for the sound waves played by the given audio sections.
+	 * Other sections of the level sequence playing the same sound waves are included, so they stay in sync with the trimmed audio.
+	 * The run goes through the queue of UAudioTrimmerSubsystem, so it never races other runs, and is finished on return.
+	 * @param LevelSequence The level sequence containing the audio sections.
+	 * @param AudioSections The audio sections to trim, e.g. the ones selected in Sequencer. */
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
-	static void RunLevelSequenceAudioTrimmer(const ULevelSequence* LevelSequence);
+	static void RunAudioSectionsTrimmer(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections);
+
+	/** Exports, trims and reimports the sound waves of all given plans, trimming and converting files in parallel.
+	 * @param RunName Unique name of the run, names its journal and report.
+	 * @param AssetPlans The plans to process, sorted by priority.
+	 * @param Callbacks Progress and per-asset callbacks, the run stops after the batch whose progress callback returns false.
+	 * @return True if all plans were processed, false if the run was stopped by the time limit or the progress callback. */
+	static bool RunAssetPlans(const FString& RunName, const TArray<FAudioTrimmerAssetPlan>& AssetPlans, const FAudioTrimmerRunCallbacks& Callbacks = {});
+
+	/** Returns true if the resident memory of this process exceeds the memory budget from the settings, always false if there is no budget.
+	 * Commandlets always have a budget, see UAudioTrimmerSettings::GetMemoryBudgetMB. */
+	static bool IsOverMemoryBudget();
+
+	/** Collects garbage if the memory budget from the settings is exceeded, so assets of already trimmed level sequences are unloaded.
+	 * Must be called only when no raw pointers to assets of the run are kept on the stack.
+	 * @return true if garbage was collected. */
+	static bool CollectGarbageIfOverBudget();
+
+	/** Groups all audio sections of the given level sequence by their sound waves and calculates the used range of each sound wave.
+	 * Padding and the minimum savings from UAudioTrimmerSettings are applied, so low-value work is dropped before any I/O.
+	 * Plans are sorted by estimated savings, biggest first.
+	 * @param LevelSequence The level sequence to plan trimming for.
+	 * @return One plan per sound wave used in the level sequence. */
+	static TArray<FAudioTrimmerAssetPlan> PlanLevelSequenceAudioTrimming(const ULevelSequence* LevelSequence);
+
+	/** Plans trimming of the sound waves played by the given audio sections, along with all other sections of the level sequence playing them.
+	 * @param LevelSequence The level sequence containing the audio sections.
+	 * @param AudioSections The audio sections whose sound waves are trimmed.
+	 * @return One plan per sound wave played by the given sections. */
+	static TArray<FAudioTrimmerAssetPlan> PlanAudioSectionsTrimming(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections);
+
+	/** Adds the used ranges of given audio sections to the plans of their sound waves, creating missing plans.
+	 * Call FinalizeAssetPlans once all sections, possibly from several level sequences, are added.
+	 * @param LevelSequence The level sequence containing the audio sections.
+	 * @param AudioSections The audio sections to add.
+	 * @param InOutAssetPlans The plans to extend. */
+	static void AddAudioSectionsToPlans(const ULevelSequence* LevelSequence, const TArray<UMovieSceneAudioSection*>& AudioSections, TArray<FAudioTrimmerAssetPlan>& InOutAssetPlans);
+
+	/** Applies the trimming policy to complete plans and sorts them by estimated savings, biggest first. */
+	static void FinalizeAssetPlans(TArray<FAudioTrimmerAssetPlan>& InOutAssetPlans);
+
+	/** Extends used ranges by the padding from the settings and marks sound waves with too small savings as skipped.
+	 * @param InOutAssetPlans The plans to update. */
+	static void ApplyTrimmingPolicy(TArray<FAudioTrimmerAssetPlan>& InOutAssetPlans);
+
+	/** Estimates the size of the source audio of the plan after trimming and the configured format conversions.
+	 * @param AssetPlan The plan with the used range and the sound wave.
+	 * @return Expected size in bytes of the trimmed source audio. */
+	static int64 EstimateTrimmedBytes(const FAudioTrimmerAssetPlan& AssetPlan);
+
+	/** Exports, trims, reimports the sound wave of the given plan and rebases all its sections.
+	 * Each step is recorded in the journal, so finished assets are skipped and partial ones are finished when the run is resumed.
+	 * @param AssetPlan The sound wave to trim with all its sections.
+	 * @param Journal The journal of the current run.
+	 * @return True if the asset is trimmed or was already trimmed by the interrupted run. */
+	static bool ProcessAssetPlan(const FAudioTrimmerAssetPlan& AssetPlan, FAudioTrimmerJournal& Journal);
+
+	/** First stage of processing a plan, runs on the game thread.
+	 * Exports the sound wave into a temporary WAV file, or marks the job as already reimported or committed by an interrupted run.
+	 * @param InOutJob The job with the plan to export, receives the exported file. */
+	static void ExportAssetPlan(FAudioTrimmerAssetJob& InOutJob, FAudioTrimmerJournal& Journal);
+
+	/** Second stage of processing a plan, touches only files, so jobs of different sound waves can run in parallel.
+	 * Trims the exported audio, verifies it against the source if enabled, then downmixes and resamples it.
+	 * @param InOutJob The exported job, receives the file to reimport or is marked as failed. */
+	static void ProcessAssetFiles(FAudioTrimmerAssetJob& InOutJob, FAudioTrimmerJournal& Journal);
+
+	/** Last stage of processing a plan, runs on the game thread.
+	 * Reimports the processed audio, saves the sound wave, then rebases and saves all sections of the plan.
+	 * @param InOutJob The processed job.
+	 * @return True if the sound wave is trimmed and all its sections are rebased. */
+	static bool CommitAssetPlan(FAudioTrimmerAssetJob& InOutJob, FAudioTrimmerJournal& Journal);
+
+	/** Creates the report entry of the given plan with its original size and duration.
+	 * @param AssetPlan The plan of the sound wave.
+	 * @param Status How the sound wave was processed.
+	 * @param Reason Why the sound wave was skipped or failed. */
+	static FAudioTrimmerAssetReport MakeAssetReport(const FAudioTrimmerAssetPlan& AssetPlan, EAudioTrimmerAssetStatus Status, const FString& Reason = FString());
 
 	/** Retrieves all audio sections from the given level sequence.
 	 * @param LevelSequence The level sequence to search for audio sections.
@@ -31,6 +123,30 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
 	static TArray<UMovieSceneAudioSection*> GetAudioSections(const ULevelSequence* LevelSequence);
 
+	/** Retrieves all audio sections that can be heard when the given level sequence is played, including its sub-sequences.
+	 * Inactive sections, muted tracks and sections entirely outside the playback range are left out.
+	 * @param LevelSequence The level sequence to search for audio sections.
+	 * @return Array of UMovieSceneAudioSection objects heard within the level sequence. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	static TArray<UMovieSceneAudioSection*> GetAudibleAudioSections(const ULevelSequence* LevelSequence);
+
+	/** Returns the used frames of every audio section of the given level sequence and its sub-sequences.
+	 * Audible sections are clipped by the playback range and by the bounds of every parent sub-section of the same package.
+	 * Inaudible sections and sections of other packages keep their full range, since they may be played elsewhere.
+	 * @param LevelSequence The level sequence to search for audio sections.
+	 * @param OutAudibleSections Optional output of the sections that can be heard when the level sequence is played.
+	 * @return Used frames of each section, in the tick resolution of the movie scene owning the section. */
+	static TMap<UMovieSceneAudioSection*, TRange<FFrameNumber>> GetSectionRanges(const ULevelSequence* LevelSequence, TSet<UMovieSceneAudioSection*>* OutAudibleSections = nullptr);
+
+	/** Adds the used frames of audio sections of the given movie scene and its sub-sequences.
+	 * @param MovieScene The movie scene to search for audio sections.
+	 * @param ClipRange Frames of the movie scene that can be played, in its tick resolution, empty if it is never heard.
+	 * @param bKeepFullRanges Whether sections are used in full, as the movie scene belongs to another package.
+	 * @param InOutSectionRanges Used frames of each section, extended if a section is reached several times.
+	 * @param InOutAudibleSections Sections that can be heard within the clip range.
+	 * @param Depth Number of parent sub-sections, stops cyclic sub-sequences. */
+	static void AddSectionRanges(const UMovieScene* MovieScene, const TRange<FFrameNumber>& ClipRange, bool bKeepFullRanges, TMap<UMovieSceneAudioSection*, TRange<FFrameNumber>>& InOutSectionRanges, TSet<UMovieSceneAudioSection*>& InOutAudibleSections, int32 Depth = 0);
+
 	/** Calculates the start and end times in milliseconds for trimming an audio section.
 	 * @param LevelSequence The level sequence containing the audio section.
 	 * @param AudioSection The audio section to calculate trim times for.
@@ -39,7 +155,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
 	static void CalculateTrimTimes(const ULevelSequence* LevelSequence, UMovieSceneAudioSection* AudioSection, int32& StartTimeMs, int32& EndTimeMs);
 
+	/** Calculates the start and end times in milliseconds of the sound played by the given used part of an audio section.
+	 * Pitch changes are followed, and a looping section that reaches the end of the sound keeps all of it.
+	 * @param AudioSection The audio section to calculate trim times for.
+	 * @param SectionRange Used frames of the section, see GetSectionRanges.
+	 * @param StartTimeMs Output parameter for the start time in milliseconds.
+	 * @param EndTimeMs Output parameter for the end time in milliseconds. */
+	static void CalculateSectionTrimTimes(const UMovieSceneAudioSection* AudioSection, const TRange<FFrameNumber>& SectionRange, int32& StartTimeMs, int32& EndTimeMs);
+
+	/** Returns how many seconds of the sound are played by the section between the given frames, following its pitch.
+	 * The pitch multiplier curve is integrated over time, and clamped the same way the audio engine clamps it.
+	 * @param AudioSection The audio section playing the sound.
+	 * @param StartFrame The first frame, in the tick resolution of the movie scene owning the section.
+	 * @param EndFrame The frame after the last one. */
+	static double GetPlayedAudioSeconds(const UMovieSceneAudioSection* AudioSection, FFrameNumber StartFrame, FFrameNumber EndFrame);
+
 	/** Trims an audio file to the specified start and end times.
+	 * Uncompressed WAV and RF64 files are streamed in-process through a fixed-size buffer, other formats fall back to ffmpeg.
+	 * In-process cuts can be snapped to zero crossings and faded, see UAudioTrimmerSettings.
 	 * @param InputPath The file path to the audio file to trim.
 	 * @param OutputPath The file path to save the trimmed audio file.
 	 * @param StartTimeSec The start time in seconds to trim from.
@@ -48,12 +181,53 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
 	static bool TrimAudio(const FString& InputPath, const FString& OutputPath, float StartTimeSec, float EndTimeSec);
 
+	/** Trims an uncompressed WAV file to the given frames in-process, applying the click-free cut options from the settings.
+	 * @param InputPath The file path to the WAV file to trim.
+	 * @param OutputPath The file path to save the trimmed WAV file.
+	 * @param InOutFrameRange The frames to keep, receives the actual range after snapping to zero crossings.
+	 * @param SourceHash Hash of the source audio, if set and the trim cache is enabled, the result is taken from or stored in the cache.
+	 * @param OutStats If set and the analysis is enabled, receives the levels of the kept frames, measured in the same pass that copies them.
+	 * @return True if the audio was successfully trimmed, false otherwise. */
+	static bool TrimAudioFrames(const FString& InputPath, const FString& OutputPath, FAudioTrimmerFrameRange& InOutFrameRange, const FString& SourceHash = FString(), FAudioTrimmerAudioStats* OutStats = nullptr);
+
+	/** Trims an audio file to the specified start and end times using the ffmpeg executable.
+	 * @return True if ffmpeg successfully trimmed the audio, false otherwise. */
+	static bool TrimAudioWithFfmpeg(const FString& InputPath, const FString& OutputPath, float StartTimeSec, float EndTimeSec);
+
+	/** Trims audio in memory by streaming it through the standard input and output of the ffmpeg executable.
+	 * The result is decoded to PCM with the bit depth of the source, or 16-bit if the source has none.
+	 * @param InputBytes The whole source audio file.
+	 * @param OutBytes Receives the trimmed WAV file.
+	 * @param FrameRange Frames to keep, in the sample rate of the source. */
+	static bool TrimAudioWithFfmpegPipes(TConstArrayView<uint8> InputBytes, TArray<uint8>& OutBytes, const FAudioTrimmerFrameRange& FrameRange);
+
+	/** Decodes the whole audio in memory by streaming it through the standard input and output of the ffmpeg executable.
+	 * @param InputBytes The whole source audio file.
+	 * @param OutBytes Receives the decoded WAV file, with the bit depth of the source, or 16-bit if the source has none. */
+	static bool DecodeAudioWithFfmpegPipes(TConstArrayView<uint8> InputBytes, TArray<uint8>& OutBytes);
+
+	/** Returns true if any enabled setting works on the samples of the trimmed audio:
+	 * the trim cache, click-free cuts, verification, downmix or resampling.
+	 * Piped sources are then decoded into a WAV file, which is trimmed the same way as uncompressed exports. */
+	static bool IsDecodedSourceRequired();
+
+	/** Converts the sample rate of an uncompressed WAV file using a polyphase windowed-sinc resampler.
+	 * @param InputPath The file path to the WAV file to resample.
+	 * @param OutputPath The file path to save the resampled WAV file.
+	 * @param TargetSampleRate The sample rate of the output file.
+	 * @return True if the audio was successfully resampled, false otherwise. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	static bool ResampleAudio(const FString& InputPath, const FString& OutputPath, int32 TargetSampleRate);
+
 	/** Exports a sound wave to a WAV file.
 	 * @param SoundWave The sound wave to export.
 	 * @return The file path to the exported WAV file. */
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
 	static FString ExportSoundWaveToWav(USoundWave* SoundWave);
 
+	/** Returns the path of the WAV file the given sound wave is exported to. */
+	static FString GetExportPath(const USoundWave* SoundWave);
+
 	/** Reimports an audio file into the original sound wave asset in Unreal Engine.
 	 * @param OriginalSoundWave The original sound wave asset to be reimported.
 	 * @param TrimmedAudioFilePath The file path to the trimmed audio file.
@@ -61,11 +235,36 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
 	static bool ReimportAudioToUnreal(USoundWave* OriginalSoundWave, const FString& TrimmedAudioFilePath);
 
+	/** Replaces the source audio of the sound wave with the given WAV data without going through a file.
+	 * @param SoundWave The sound wave to update.
+	 * @param WavBytes The whole uncompressed WAV file. */
+	static bool ReimportAudioFromMemory(USoundWave* SoundWave, const TArray<uint8>& WavBytes);
+
+	/** Replaces the source audio of the sound wave with the given WAV data and updates the properties derived from it.
+	 * Neither records an undo transaction nor dirties the package, so it is also used for in-memory changes at cook time.
+	 * @param SoundWave The sound wave to update.
+	 * @param WavBytes The whole uncompressed WAV file. */
+	static bool SetSoundWavePayload(USoundWave* SoundWave, const TArray<uint8>& WavBytes);
+
+	/** Stores the levels of the trimmed audio in the package metadata of the sound wave, under keys starting with 'AudioTrimmer.'. */
+	static void WriteAudioStatsMetaData(USoundWave* SoundWave, const FAudioTrimmerAudioStats& Stats);
+
 	/** Resets the start frame offset of an audio section to zero.
 	 * @param AudioSection The audio section to modify. */
 	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
 	static void ResetStartFrameOffset(UMovieSceneAudioSection* AudioSection);
 
+	/** Shifts the start frame offset of an audio section by the time trimmed from the beginning of its sound.
+	 * @param AudioSection The audio section to modify.
+	 * @param TrimStartTimeMs The time in milliseconds cut from the beginning of the sound. */
+	UFUNCTION(BlueprintCallable, Category = "Audio Trimmer")
+	static void RebaseStartFrameOffset(UMovieSceneAudioSection* AudioSection, int32 TrimStartTimeMs);
+
+	/** Shifts the start frame offset of an audio section by the exact time trimmed from the beginning of its sound.
+	 * @param AudioSection The audio section to modify.
+	 * @param TrimStartTimeSec The time in seconds cut from the beginning of the sound. */
+	static void RebaseStartFrameOffsetBySeconds(UMovieSceneAudioSection* AudioSection, double TrimStartTimeSec);
+
 	/** Deletes a temporary WAV file from the file system. * 
 	 * @param FilePath The file path of the WAV file to delete.
 	 * @return True if the file was successfully deleted, false otherwise. */
@@ -0,0 +1,84 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+//---
+#include "AudioTrimmerManifest.h"
+#include "Containers/Ticker.h"
+#include "UObject/UObjectGlobals.h"
+
+class UPackage;
+class FObjectPostSaveContext;
+
+/**
+ * Opt-in editor mode that keeps sound waves tight while level sequences are edited.
+ * Every saved level sequence is compared against its last known usage in the usage manifest,
+ * and only sound waves whose used range across all level sequences shrank are queued.
+ * Queued sound waves are submitted as one job to UAudioTrimmerSubsystem once the editor stays idle for the configured delay after the last save.
+ * Level sequences changed since the last session are loaded in the background once the asset registry finished loading, so the editor starts without waiting for them.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerWatcher : public TSharedFromThis<FAudioTrimmerWatcher>
+{
+public:
+	/** Returns true if this process is an interactive editor and watching is enabled in the settings. */
+	static bool ShouldWatch();
+
+	/** Loads the usage manifest, starts listening for saved level sequences and refreshes the manifest once the asset registry finished loading. */
+	void Start();
+
+	/** Stops listening, drops queued sound waves and saves the usage manifest if it changed. */
+	void Stop();
+
+	/** Returns true while level sequences changed since the last session are being loaded into the manifest. */
+	bool IsRefreshing() const { return !SequencesToRefresh.IsEmpty() || NumRefreshLoads > 0; }
+
+protected:
+	/** Collects level sequences changed since the last session, they are loaded in the background by the ticker. */
+	void StartRefresh();
+
+	/** Starts loading the next changed level sequences, up to the prefetch count from the settings. */
+	void LoadSequencesToRefresh();
+
+	/** Is called once a changed level sequence is loaded to update its usage in the manifest. */
+	void OnRefreshSequenceLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result);
+
+	/** Is called after any package is saved to queue sound waves whose used range shrank. */
+	void OnPackageSaved(const FString& PackageFilename, UPackage* Package, FObjectPostSaveContext ObjectSaveContext);
+
+	/** Is called by the ticker to refresh the manifest, save it and trim queued sound waves once no package was saved for a while. */
+	bool Tick(float DeltaTime);
+
+	/** Submits one job that loads all level sequences playing queued sound waves and trims those sound waves. */
+	void TrimQueuedSounds();
+
+	/** Returns the union of used frames of each given sound wave across all level sequences of the manifest. */
+	TMap<FString, FAudioTrimmerFrameRange> GetUsedRanges(const TSet<FString>& SoundWavePaths) const;
+
+	/** Last known usages of all level sequences. */
+	FAudioTrimmerManifest Manifest;
+
+	/** Path names of sound waves waiting to be trimmed. */
+	TSet<FString> QueuedSounds;
+
+	/** Package names of changed level sequences waiting to be loaded into the manifest. */
+	TArray<FName> SequencesToRefresh;
+
+	/** Number of changed level sequences being loaded in the background. */
+	int32 NumRefreshLoads = 0;
+
+	/** Is true if the manifest changed since it was saved, it is saved once the editor is idle or the watcher stops. */
+	bool bManifestDirty = false;
+
+	/** Time of the last saved level sequence, queued sound waves wait until the editor is idle. */
+	double LastSaveTime = 0.0;
+
+	/** Handle to the package saved delegate. */
+	FDelegateHandle OnPackageSavedHandle;
+
+	/** Handle to the delegate called once the asset registry finished loading. */
+	FDelegateHandle OnFilesLoadedHandle;
+
+	/** Handle to the ticker that trims queued sound waves. */
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,217 @@
+﻿// Copyright (c) Yevhenii Selivanov
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+#include "Templates/UniquePtr.h"
+
+class FAudioTrimmerAnalyzer;
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Half-open range of sample frames [StartFrame, EndFrame) inside a WAV data chunk.
+ * One frame holds one sample for every channel.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerFrameRange
+{
+	int64 StartFrame = 0;
+	int64 EndFrame = 0;
+
+	FAudioTrimmerFrameRange() = default;
+	FAudioTrimmerFrameRange(int64 InStartFrame, int64 InEndFrame) : StartFrame(InStartFrame), EndFrame(InEndFrame) {}
+
+	int64 Num() const { return FMath::Max<int64>(EndFrame - StartFrame, 0); }
+	bool IsEmpty() const { return EndFrame <= StartFrame; }
+};
+
+/**
+ * Format and data chunk location of a RIFF, RF64 or BW64 WAV file.
+ */
+struct LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerWavHeader
+{
+	/** 1 = integer PCM, 3 = IEEE float, 0xFFFE = WAVE_FORMAT_EXTENSIBLE. */
+	uint16 FormatTag = 0;
+	uint16 NumChannels = 0;
+	uint32 SampleRate = 0;
+	uint16 BitsPerSample = 0;
+	uint16 BlockAlign = 0;
+
+	/** Raw payload of the 'fmt ' chunk, written back verbatim to keep the extensible format intact. */
+	TArray<uint8> FormatChunk;
+
+	/** Absolute byte offset of the first sample in the file. */
+	int64 DataOffset = 0;
+
+	/** Size in bytes of the sample data. */
+	int64 DataSize = 0;
+
+	/** Returns the number of sample frames stored in the data chunk. */
+	int64 GetNumFrames() const { return BlockAlign > 0 ? DataSize / BlockAlign : 0; }
+
+	/** Returns true if samples are uncompressed, so the data chunk can be sliced by frames. */
+	bool IsUncompressed() const;
+
+	/** Returns true if samples are stored as IEEE floats. */
+	bool IsFloat() const;
+
+	/** Returns the size in bytes of one sample of one channel. */
+	int32 GetBytesPerSample() const { return NumChannels > 0 ? BlockAlign / NumChannels : 0; }
+
+	/** Creates the header of a plain PCM or IEEE float WAV file with the given format. */
+	static FAudioTrimmerWavHeader Make(uint16 InNumChannels, uint32 InSampleRate, uint16 InBitsPerSample, bool bInFloat);
+};
+
+/**
+ * Read-only memory-mapped view of the sample data of a WAV file.
+ * Extracting a range of frames returns a slice of the mapping, so samples are served from the OS page cache without copies,
+ * and concurrent jobs reading the same source share the same physical pages.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerMappedWav
+{
+public:
+	FAudioTrimmerMappedWav() = default;
+	~FAudioTrimmerMappedWav();
+
+	FAudioTrimmerMappedWav(const FAudioTrimmerMappedWav&) = delete;
+	FAudioTrimmerMappedWav& operator=(const FAudioTrimmerMappedWav&) = delete;
+
+	/** Maps the data chunk of the given WAV file.
+	 * @return True if the file is an uncompressed WAV file and its samples were mapped. */
+	bool Open(const FString& FilePath);
+
+	/** Releases the mapping, is called automatically on destruction. */
+	void Close();
+
+	/** Returns true if the samples are mapped and can be accessed. */
+	bool IsOpen() const { return MappedRegion != nullptr; }
+
+	/** Returns the parsed header of the mapped file. */
+	const FAudioTrimmerWavHeader& GetHeader() const { return Header; }
+
+	/** Returns the bytes of the given frame range, clamped to the file length.
+	 * The view stays valid until this file is closed. */
+	TConstArrayView64<uint8> GetFrames(const FAudioTrimmerFrameRange& FrameRange) const;
+
+private:
+	FAudioTrimmerWavHeader Header;
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+};
+
+/**
+ * Streaming WAV reader/writer used by the trimmer to cut sample ranges without loading whole files into memory.
+ * Input and output are moved through a fixed-size buffer, so memory usage does not depend on the file size.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerWav
+{
+public:
+	/** Upper bound of the memory used while copying samples from the input to the output file. */
+	static constexpr int64 StreamChunkSize = 8 * 1024 * 1024;
+
+	/** Largest data chunk a classic RIFF file can describe, bigger outputs are written as RF64. */
+	static constexpr int64 MaxRiffDataSize = MAX_uint32 - 1024;
+
+	/** Parses the header of the given WAV file.
+	 * @param FileHandle Opened file to read, its position is changed.
+	 * @param OutHeader Receives the parsed format and data chunk location.
+	 * @return True if the file is a valid RIFF, RF64 or BW64 WAV file. */
+	static bool ReadHeader(IFileHandle& FileHandle, FAudioTrimmerWavHeader& OutHeader);
+
+	/** Parses the header of the WAV file at the given path. */
+	static bool ReadHeader(const FString& FilePath, FAudioTrimmerWavHeader& OutHeader);
+
+	/** Parses the header of WAV data in memory, data offset is relative to the first byte. */
+	static bool ReadHeader(TConstArrayView<uint8> WavBytes, FAudioTrimmerWavHeader& OutHeader);
+
+	/** Replaces the placeholder RIFF and data chunk sizes written by encoders that stream to a pipe with the actual sizes.
+	 * @param InOutWavBytes Whole RIFF WAV file in memory, its data chunk is expected to be the last one.
+	 * @return True if the data chunk was found and patched. */
+	static bool PatchStreamedSizes(TArray<uint8>& InOutWavBytes);
+
+	/** Writes a WAV header for the given format followed by the empty data chunk header.
+	 * RF64 with a 'ds64' chunk is written when the data does not fit into a classic RIFF file.
+	 * @param FileHandle Opened file to write to at its current position.
+	 * @param Header Format of the samples to write.
+	 * @param DataSize Size in bytes of the sample data that will follow the header. */
+	static bool WriteHeader(IFileHandle& FileHandle, const FAudioTrimmerWavHeader& Header, int64 DataSize, bool bForceRF64 = false);
+
+	/** Converts raw samples of the given format into floats in the [-1, 1] range.
+	 * @param Bytes Whole samples in the format of the header.
+	 * @param Header Format of the samples.
+	 * @param OutSamples Receives one float per sample, interleaved the same way as the input. */
+	static void DecodeSamples(TConstArrayView<uint8> Bytes, const FAudioTrimmerWavHeader& Header, TArray<float>& OutSamples);
+
+	/** Converts floats in the [-1, 1] range into raw samples of the given format, appending them to the output. */
+	static void EncodeSamples(TConstArrayView<float> Samples, const FAudioTrimmerWavHeader& Header, TArray<uint8>& OutBytes);
+
+	/** Reads and decodes a small range of frames of the given WAV file.
+	 * @param FilePath The uncompressed WAV file to read.
+	 * @param Header The header of the file.
+	 * @param FrameRange The frames to read, clamped to the file length.
+	 * @param OutSamples Receives the interleaved samples of the range.
+	 * @return The actual range that was read, empty on failure. */
+	static FAudioTrimmerFrameRange ReadFrames(const FString& FilePath, const FAudioTrimmerWavHeader& Header, const FAudioTrimmerFrameRange& FrameRange, TArray<float>& OutSamples);
+
+	/** Decodes, modifies and writes back a range of frames of the given WAV file in place.
+	 * @param FilePath The uncompressed WAV file to modify.
+	 * @param FrameRange The frames to modify, clamped to the file length.
+	 * @param Modifier Is called with the interleaved samples of the range and its first frame. */
+	static bool ModifyFrames(const FString& FilePath, const FAudioTrimmerFrameRange& FrameRange, TFunctionRef<void(TArrayView<float> InterleavedSamples, int64 StartFrame)> Modifier);
+
+	/** Decodes all samples of the given WAV file chunk by chunk, so at most StreamChunkSize bytes of floats are resident at once.
+	 * @param InputPath The WAV file to read.
+	 * @param OutHeader Receives the header of the file.
+	 * @param Visitor Is called with the interleaved samples of each chunk in order, returns false to stop reading.
+	 * @return True if the file was read completely. */
+	static bool ForEachSampleChunk(const FString& InputPath, FAudioTrimmerWavHeader& OutHeader, TFunctionRef<bool(TConstArrayView<float> InterleavedSamples)> Visitor);
+
+	/** Copies the given frame ranges of the input WAV file into a new WAV file, one after another.
+	 * Samples are written straight from a memory-mapped view of the input when the platform supports it,
+	 * otherwise they are streamed through a buffer of StreamChunkSize bytes.
+	 * @param InputPath The WAV file to read from.
+	 * @param OutputPath The WAV file to create, overwritten if exists.
+	 * @param FrameRanges Sorted ranges of frames to copy, clamped to the input length.
+	 * @param Analyzer If set, receives every copied frame in the same pass, initialized for the format of the input by the caller.
+	 * @return True if the output file was successfully written. */
+	static bool CopyFrameRanges(const FString& InputPath, const FString& OutputPath, const TArray<FAudioTrimmerFrameRange>& FrameRanges, FAudioTrimmerAnalyzer* Analyzer = nullptr);
+};
+
+/**
+ * Writes float samples into a new WAV file of any uncompressed format, the header is patched with the final size on close.
+ */
+class LEVELSEQUENCERAUDIOTRIMMERED_API FAudioTrimmerWavWriter
+{
+public:
+	FAudioTrimmerWavWriter() = default;
+	~FAudioTrimmerWavWriter();
+
+	FAudioTrimmerWavWriter(const FAudioTrimmerWavWriter&) = delete;
+	FAudioTrimmerWavWriter& operator=(const FAudioTrimmerWavWriter&) = delete;
+
+	/** Creates the file and writes its header.
+	 * @param FilePath The WAV file to create, overwritten if exists.
+	 * @param InHeader Format of the samples to write.
+	 * @param ExpectedNumFrames Estimated length of the output, decides whether RF64 header is needed. */
+	bool Open(const FString& FilePath, const FAudioTrimmerWavHeader& InHeader, int64 ExpectedNumFrames);
+
+	/** Encodes and appends interleaved samples to the file. */
+	bool Write(TConstArrayView<float> InterleavedSamples);
+
+	/** Patches the header with the actual data size and closes the file.
+	 * @return True if all samples and the header were successfully written. */
+	bool Close();
+
+	/** Returns the number of frames written so far. */
+	int64 GetNumFramesWritten() const { return Header.BlockAlign > 0 ? DataSize / Header.BlockAlign : 0; }
+
+private:
+	FAudioTrimmerWavHeader Header;
+	TUniquePtr<IFileHandle> FileHandle;
+	TArray<uint8> EncodeBuffer;
+	int64 DataSize = 0;
+	bool bRF64 = false;
+	bool bFailed = false;
+};
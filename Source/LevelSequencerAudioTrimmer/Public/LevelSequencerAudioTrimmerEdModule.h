@@ -6,6 +6,10 @@
 //---
 #include "CoreMinimal.h"
 
+class FAudioTrimmerCookTrimmer;
+class FAudioTrimmerWatcher;
+struct FToolMenuContext;
+
 class LEVELSEQUENCERAUDIOTRIMMERED_API FLevelSequencerAudioTrimmerEdModule : public IModuleInterface
 {
 public:
@@ -29,6 +33,9 @@ public:
 	/** Is called when Audio Trimmer button in clicked in the context menu of the Level Sequence asset. */
 	void OnLevelSequencerAudioTrimmerClicked();
 
+	/** Is called when the Trim Selected Audio button is clicked in the Sequencer toolbar. */
+	void OnTrimSelectedSectionsClicked(const FToolMenuContext& Context);
+
 	/*********************************************************************************************
 	 * Plugin name/path
 	 ********************************************************************************************* */
@@ -58,4 +65,24 @@ protected:
 
 	/** Current path to the FFMPEG library. */
 	static FString FfmpegPath;
-};
+
+	/*********************************************************************************************
+	 * Cook-time trimming
+	 ********************************************************************************************* */
+protected:
+	/** Starts trimming sound waves in memory if this process is a cook and it is enabled in the settings. */
+	void StartCookTrimmer();
+
+	/** Trims sound waves while cooking without modifying source assets, is null outside of the cook. */
+	TSharedPtr<FAudioTrimmerCookTrimmer> CookTrimmer = nullptr;
+
+	/*********************************************************************************************
+	 * Watch mode
+	 ********************************************************************************************* */
+protected:
+	/** Starts trimming sound waves of saved level sequences if it is enabled in the settings. */
+	void StartWatcher();
+
+	/** Trims sound waves whose used range shrank in saved level sequences, is null if watching is disabled. */
+	TSharedPtr<FAudioTrimmerWatcher> Watcher = nullptr;
+};
\ No newline at end of file